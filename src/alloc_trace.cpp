@@ -0,0 +1,31 @@
+#ifdef TSDS_MODULE
+
+/**
+ * @module tsds.alloc_trace
+ * @brief Defines an allocation trace recorder, and an allocator wrapper that
+ * feeds it.
+ * @see tsds::AllocTrace
+ * @see tsds::TracedAlloc
+ */
+
+module;
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+export module tsds.alloc_trace;
+
+#include "alloc_trace.hpp"
+#endif
@@ -0,0 +1,330 @@
+/**
+ * @file alloc_trace.hpp
+ * @brief Contains definitions of @ref tsds::AllocTrace and
+ * @ref tsds::TracedAlloc.
+ */
+
+#ifndef TSDS_ALLOC_TRACE_HPP
+#define TSDS_ALLOC_TRACE_HPP
+
+#ifndef TSDS_MODULE
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#endif // !TSDS_MODULE
+
+#ifdef TSDS_MODULE
+export namespace tsds {
+#else
+namespace tsds {
+#endif // !TSDS_MODULE
+
+/**
+ * @class AllocTrace
+ * @brief Records allocations and deallocations into a fixed-size buffer, to
+ * be dumped into a compact binary trace.
+ *
+ * Recording is thread-safe and lock-free: each event takes a slot with one
+ * @c fetch_add. Once the buffer is full, further events are dropped and
+ * counted in @ref dropped.
+ *
+ * Events are stored in the order they took their slot. An allocation is
+ * recorded after the allocator returns, and a deallocation before the memory
+ * is given back. So, if an address is freed then handed out again, the free
+ * always comes first in the trace.
+ *
+ * @ref events, @ref write and @ref dropped must only be called once the
+ * recording threads are done.
+ *
+ * The trace is written in the host's byte order. Each event is written field
+ * by field, @ref RECORD_SIZE bytes with no padding in between.
+ */
+class AllocTrace {
+public:
+  enum class EventKind : std::uint8_t { Alloc, Free };
+  /**
+   * @class Event
+   * @brief One record in the trace.
+   */
+  struct Event {
+    /// Nanoseconds since the @ref AllocTrace was constructed.
+    std::uint64_t timestamp;
+    /// The address of the block. Pairs a @c Free with its @c Alloc.
+    std::uint64_t addr;
+    /// Byte size. 0 for @c Free.
+    std::uint32_t size;
+    /// A per-process number for the calling thread. Never reused.
+    std::uint32_t thread;
+    /// log2 of the alignment. 0 for @c Free.
+    std::uint8_t align_log2;
+    EventKind kind;
+  };
+  static_assert(std::is_trivially_copyable_v<Event>);
+  /// The byte size of one @ref Event in the trace file.
+  static constexpr std::size_t RECORD_SIZE =
+      sizeof(Event::timestamp) + sizeof(Event::addr) + sizeof(Event::size) +
+      sizeof(Event::thread) + sizeof(Event::align_log2) + sizeof(Event::kind);
+
+  /**
+   * @brief Allocates room for @p t_capacity events up front.
+   */
+  explicit AllocTrace(std::size_t t_capacity)
+      : m_events(std::make_unique<Event[]>(t_capacity)),
+        m_capacity(t_capacity) {}
+
+  /**
+   * @brief Records that @p t_ptr was handed out.
+   * @param t_ptr Ignored if @c nullptr.
+   * @param t_align Must be a power of 2.
+   */
+  void record_alloc(const void* t_ptr, std::size_t t_size,
+                    std::size_t t_align) noexcept {
+    if (t_ptr == nullptr) {
+      return;
+    }
+    record({.timestamp = 0,
+            // NOLINTNEXTLINE(*reinterpret-cast*)
+            .addr = reinterpret_cast<std::uintptr_t>(t_ptr),
+            .size = static_cast<std::uint32_t>(t_size),
+            .thread = 0,
+            .align_log2 = static_cast<std::uint8_t>(std::countr_zero(t_align)),
+            .kind = EventKind::Alloc});
+  }
+  /**
+   * @brief Records that @p t_ptr is about to be given back.
+   * @param t_ptr Ignored if @c nullptr.
+   */
+  void record_free(const void* t_ptr) noexcept {
+    if (t_ptr == nullptr) {
+      return;
+    }
+    record({.timestamp = 0,
+            // NOLINTNEXTLINE(*reinterpret-cast*)
+            .addr = reinterpret_cast<std::uintptr_t>(t_ptr),
+            .size = 0,
+            .thread = 0,
+            .align_log2 = 0,
+            .kind = EventKind::Free});
+  }
+
+  /**
+   * @brief The recorded events, in recording order.
+   */
+  [[nodiscard]] auto events() const noexcept -> std::span<const Event> {
+    return {m_events.get(),
+            std::min(m_next.load(std::memory_order::acquire), m_capacity)};
+  }
+  /**
+   * @brief How many events didn't fit into the buffer.
+   */
+  [[nodiscard]] auto dropped() const noexcept -> std::size_t {
+    auto next = m_next.load(std::memory_order::acquire);
+    return (next > m_capacity) ? next - m_capacity : 0;
+  }
+
+  /**
+   * @brief Writes the trace into @p t_out.
+   * @return @c true if @p t_out is still good afterwards.
+   */
+  auto write(std::ostream& t_out) const -> bool {
+    auto evts = events();
+    auto cnt = static_cast<std::uint64_t>(evts.size());
+    t_out.write(MAGIC.data(), MAGIC.size());
+    // NOLINTBEGIN(*reinterpret-cast*)
+    t_out.write(reinterpret_cast<const char*>(&cnt), sizeof(cnt));
+    // NOLINTEND(*reinterpret-cast*)
+    std::vector<char> buff(std::min(evts.size(), CHUNK_EVENTS) * RECORD_SIZE);
+    for (std::size_t first = 0; first < evts.size(); first += CHUNK_EVENTS) {
+      auto chunk =
+          evts.subspan(first, std::min(CHUNK_EVENTS, evts.size() - first));
+      auto* p_out = buff.data();
+      for (const auto& evt : chunk) {
+        p_out = store(p_out, evt.timestamp);
+        p_out = store(p_out, evt.addr);
+        p_out = store(p_out, evt.size);
+        p_out = store(p_out, evt.thread);
+        p_out = store(p_out, evt.align_log2);
+        p_out = store(p_out, evt.kind);
+      }
+      t_out.write(buff.data(),
+                  static_cast<std::streamsize>(chunk.size() * RECORD_SIZE));
+    }
+    return t_out.good();
+  }
+  /**
+   * @brief Reads back a trace written by @ref write.
+   * @return The events, or @c std::nullopt if @p t_in doesn't hold a
+   * complete trace.
+   */
+  static auto read(std::istream& t_in) -> std::optional<std::vector<Event>> {
+    std::array<char, MAGIC.size()> magic{};
+    std::uint64_t cnt{};
+    t_in.read(magic.data(), magic.size());
+    // NOLINTNEXTLINE(*reinterpret-cast*)
+    t_in.read(reinterpret_cast<char*>(&cnt), sizeof(cnt));
+    if (!t_in.good() || magic != MAGIC) {
+      return std::nullopt;
+    }
+    // the count can't be trusted to size anything: grow one chunk at a time,
+    // so a bogus count fails at the end of the file instead.
+    std::vector<Event> ret{};
+    std::vector<char> buff(CHUNK_EVENTS * RECORD_SIZE);
+    for (std::uint64_t first = 0; first < cnt; first += CHUNK_EVENTS) {
+      auto chunk_cnt = static_cast<std::size_t>(
+          std::min<std::uint64_t>(CHUNK_EVENTS, cnt - first));
+      ret.resize(ret.size() + chunk_cnt);
+      auto chunk = std::span{ret}.last(chunk_cnt);
+      auto bytes = static_cast<std::streamsize>(chunk.size() * RECORD_SIZE);
+      t_in.read(buff.data(), bytes);
+      if (t_in.gcount() != bytes) {
+        return std::nullopt;
+      }
+      const auto* p_in = buff.data();
+      for (auto& evt : chunk) {
+        p_in = load(p_in, evt.timestamp);
+        p_in = load(p_in, evt.addr);
+        p_in = load(p_in, evt.size);
+        p_in = load(p_in, evt.thread);
+        p_in = load(p_in, evt.align_log2);
+        p_in = load(p_in, evt.kind);
+      }
+    }
+    return ret;
+  }
+
+private:
+  static constexpr std::array<char, 8> MAGIC{'T', 'S', 'D', 'S',
+                                             'T', 'R', 'C', '3'};
+  /// How many events @ref write and @ref read convert at a time.
+  static constexpr std::size_t CHUNK_EVENTS = 4096;
+
+  /**
+   * @brief Copies @p t_field to @p t_p_out.
+   * @return Right past the copied bytes.
+   */
+  template <typename Field>
+  static auto store(char* t_p_out, const Field& t_field) noexcept -> char* {
+    std::memcpy(t_p_out, &t_field, sizeof(Field));
+    return t_p_out + sizeof(Field);
+  }
+  /**
+   * @brief The opposite of @ref store.
+   */
+  template <typename Field>
+  static auto load(const char* t_p_in, Field& t_field) noexcept
+      -> const char* {
+    std::memcpy(&t_field, t_p_in, sizeof(Field));
+    return t_p_in + sizeof(Field);
+  }
+
+  /**
+   * @brief A number unique per thread for the whole process.
+   *
+   * 32 bits, so that even a process churning through short-lived threads
+   * doesn't wrap around and merge unrelated threads in a replay.
+   */
+  static auto thread_idx() noexcept -> std::uint32_t {
+    static std::atomic<std::uint32_t> next_idx{};
+    thread_local const auto idx =
+        next_idx.fetch_add(1, std::memory_order::relaxed);
+    return idx;
+  }
+  void record(Event t_event) noexcept {
+    auto idx = m_next.fetch_add(1, std::memory_order::acq_rel);
+    if (idx >= m_capacity) {
+      return;
+    }
+    t_event.timestamp = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_start)
+            .count());
+    t_event.thread = thread_idx();
+    m_events[idx] = t_event;
+  }
+
+  std::unique_ptr<Event[]> m_events; // NOLINT(*avoid-c-arrays*)
+  std::size_t m_capacity;
+  std::atomic<std::size_t> m_next{};
+  std::chrono::steady_clock::time_point m_start{
+      std::chrono::steady_clock::now()};
+};
+
+/**
+ * @class TracedAlloc
+ * @brief Wraps a tsds allocator, and records every call into an
+ * @ref AllocTrace.
+ * @tparam Alloc Either a @ref PoolAlloc or an @ref ArenaAlloc -like
+ * allocator.
+ *
+ * Opt-in: only allocations made through this wrapper are recorded. The
+ * wrapped allocator itself is untouched.
+ */
+template <typename Alloc> class TracedAlloc {
+public:
+  /**
+   * @param t_trace Must outlive @c this.
+   */
+  explicit TracedAlloc(AllocTrace& t_trace, Alloc t_alloc = Alloc{})
+      : m_alloc(std::move(t_alloc)), m_p_trace(&t_trace) {}
+
+  /**
+   * @copydoc tsds::PoolAlloc::allocate
+   */
+  template <typename A = Alloc>
+    requires requires { typename A::value_type; }
+  auto allocate(std::size_t t_cnt = 0) noexcept -> typename A::pointer {
+    using ValueType = typename A::value_type;
+    auto* ret = m_alloc.allocate(t_cnt);
+    m_p_trace->record_alloc(ret, sizeof(ValueType), alignof(ValueType));
+    return ret;
+  }
+  /**
+   * @copydoc tsds::PoolAlloc::deallocate
+   */
+  template <typename A = Alloc>
+    requires requires { typename A::value_type; }
+  void deallocate(typename A::pointer t_p_obj, std::size_t t_cnt = 0) noexcept {
+    m_p_trace->record_free(t_p_obj);
+    m_alloc.deallocate(t_p_obj, t_cnt);
+  }
+
+  /**
+   * @copydoc tsds::ArenaAlloc::allocate
+   */
+  template <typename A = Alloc>
+    requires requires { typename A::AllocInfo; }
+  auto allocate(typename A::AllocInfo t_alloc_info) noexcept -> void* {
+    auto* ret = m_alloc.allocate(t_alloc_info);
+    m_p_trace->record_alloc(ret, t_alloc_info.size, t_alloc_info.align);
+    return ret;
+  }
+  /**
+   * @copydoc tsds::ArenaAlloc::deallocate
+   */
+  template <typename A = Alloc>
+    requires requires { typename A::AllocInfo; }
+  void deallocate(void* t_ptr) noexcept {
+    m_p_trace->record_free(t_ptr);
+    m_alloc.deallocate(t_ptr);
+  }
+
+private:
+  Alloc m_alloc;
+  AllocTrace* m_p_trace;
+};
+}
+
+#endif // !TSDS_ALLOC_TRACE_HPP
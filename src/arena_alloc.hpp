@@ -18,6 +18,53 @@ namespace tsds {
 template <std::size_t Size>
 concept ValidSize = requires { Size > 0; };
 
+namespace detail {
+/**
+ * @brief The bump allocation shared by the arena allocators. Not part of the
+ * API.
+ * @tparam Head @c std::atomic<std::size_t> or @c std::atomic_ref<std::size_t>.
+ * @param t_p_buff The start of the buffer.
+ * @param t_buff_size The byte size of the buffer.
+ * @param t_head Index of the first free byte of the buffer.
+ * @param t_size Must be larger than 0.
+ * @param t_align Must be a power of 2.
+ * @return Pointer to the newly allocated memory block, or @c nullptr if
+ * there's no room left.
+ */
+template <typename Head>
+auto arena_bump(std::uint8_t* t_p_buff, std::size_t t_buff_size, Head& t_head,
+                std::size_t t_size, std::uintptr_t t_align) noexcept -> void* {
+  auto align_index = [&](std::size_t t_idx) -> std::size_t {
+    // similar to curr_head_num % curr_head_idx since we assume align is a
+    // power of 2
+    auto* head_ptr = t_p_buff + t_idx;
+    // NOLINTNEXTLINE(*reinterpret-cast*)
+    auto curr_head_num = reinterpret_cast<std::uintptr_t>(head_ptr);
+    auto mod = curr_head_num & (t_align - 1);
+    return (mod == 0) ? t_idx
+                      : static_cast<std::size_t>(t_idx + t_align - mod);
+  };
+
+  auto curr_head_idx = t_head.load(std::memory_order::relaxed);
+  auto aligned_idx = align_index(curr_head_idx);
+  auto next_head_idx = static_cast<std::size_t>(aligned_idx + t_size);
+  if (next_head_idx >= t_buff_size) {
+    return nullptr;
+  }
+
+  while (!t_head.compare_exchange_weak(curr_head_idx, next_head_idx,
+                                       std::memory_order::release,
+                                       std::memory_order::acquire)) {
+    aligned_idx = align_index(curr_head_idx);
+    next_head_idx = static_cast<std::size_t>(aligned_idx + t_size);
+    if (next_head_idx >= t_buff_size) {
+      return nullptr;
+    }
+  }
+  return static_cast<void*>(t_p_buff + aligned_idx);
+}
+} // namespace detail
+
 /**
  * @class ArenaAlloc
  * @brief Your everyday arena allocator, with some thread-safety.
@@ -82,36 +129,8 @@ class ArenaAlloc<Size, BuffInitAlloc>::AllocBuff {
 public:
   AllocBuff() = default;
   auto allocate(AllocInfo t_alloc_info) -> void* {
-    auto align_index = [&](std::size_t t_idx) -> std::size_t {
-      // similar to curr_head_num % curr_head_idx since we assume align is a
-      // power of 2
-      auto* head_ptr = &m_buff.front() + t_idx;
-      // NOLINTNEXTLINE(*reinterpret-cast*)
-      auto curr_head_num = reinterpret_cast<std::uintptr_t>(head_ptr);
-      auto mod = curr_head_num & (t_alloc_info.align - 1);
-      return (mod == 0)
-                 ? t_idx
-                 : static_cast<std::size_t>(t_idx + t_alloc_info.align - mod);
-    };
-
-    auto curr_head_idx = m_head_idx.load(std::memory_order::relaxed);
-    auto aligned_idx = align_index(curr_head_idx);
-    auto next_head_idx =
-        static_cast<std::size_t>(aligned_idx + t_alloc_info.size);
-    if (next_head_idx >= Size) {
-      return nullptr;
-    }
-
-    while (!m_head_idx.compare_exchange_weak(curr_head_idx, next_head_idx,
-                                             std::memory_order::release,
-                                             std::memory_order::acquire)) {
-      aligned_idx = align_index(curr_head_idx);
-      next_head_idx = static_cast<std::size_t>(aligned_idx + t_alloc_info.size);
-      if (next_head_idx >= Size) {
-        return nullptr;
-      }
-    }
-    return static_cast<void*>(&m_buff.front() + aligned_idx);
+    return detail::arena_bump(m_buff.data(), Size, m_head_idx,
+                              t_alloc_info.size, t_alloc_info.align);
   }
 
 private:
@@ -0,0 +1,23 @@
+#ifdef TSDS_MODULE
+
+/**
+ * @module tsds.channel
+ * @brief Defines an unbuffered channel between coroutines.
+ * @see tsds::Channel
+ */
+
+module;
+#include <array>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <utility>
+export module tsds.channel;
+import tsds.task;
+
+#include "channel.hpp"
+#endif
@@ -0,0 +1,318 @@
+/**
+ * @file channel.hpp
+ * @brief Contains definitions of @ref tsds::Channel.
+ */
+
+#ifndef TSDS_CHANNEL_HPP
+#define TSDS_CHANNEL_HPP
+
+#ifndef TSDS_MODULE
+#include "task.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <utility>
+#endif // !TSDS_MODULE
+
+#ifdef TSDS_MODULE
+export namespace tsds {
+#else
+namespace tsds {
+#endif // !TSDS_MODULE
+
+/**
+ * @class Channel
+ * @brief An unbuffered channel between coroutines.
+ * @tparam T The value type. Must be move constructible.
+ *
+ * @c co_await ch.send(x) and @c co_await ch.receive() meet each other: if a
+ * coroutine of the other kind is already waiting, the value is handed over
+ * and the waiting one is scheduled on its executor, all without suspending.
+ * Otherwise, the caller suspends until someone of the other kind shows up.
+ *
+ * Waiters live in a lock-free stack that only ever holds one kind at a time.
+ * The stack nodes are owned by the channel and indexed with a 32-bit tag
+ * next to the index, so there's no ABA, and a thread reading a node someone
+ * else just popped reads stale data instead of freed memory.
+ *
+ * The nodes come in segments, each twice as large as the one before. When
+ * no node is free, a new segment is allocated, so any number of coroutines
+ * can wait at once. Segments are only freed along with the channel.
+ *
+ * Only coroutines returning @ref Task can wait on a channel, since the waiter
+ * needs to know which executor to be resumed on.
+ */
+template <typename T> class Channel {
+public:
+  Channel() noexcept = default;
+  Channel(const Channel&) = delete;
+  Channel(Channel&&) = delete;
+  auto operator=(const Channel&) = delete;
+  auto operator=(Channel&&) = delete;
+  ~Channel();
+
+  class SendAwaiter;
+  class ReceiveAwaiter;
+  /**
+   * @brief Sends @p t_value to a receiver.
+   */
+  [[nodiscard]] auto send(T t_value) noexcept -> SendAwaiter {
+    return SendAwaiter{*this, std::move(t_value)};
+  }
+  /**
+   * @brief Receives a value from a sender.
+   */
+  [[nodiscard]] auto receive() noexcept -> ReceiveAwaiter {
+    return ReceiveAwaiter{*this};
+  }
+
+private:
+  enum class Kind : std::uint8_t { Send, Receive };
+  /**
+   * @class Waiter
+   * @brief A suspended coroutine.
+   *
+   * @c next and @c kind may be read by a thread that's about to lose a CAS,
+   * so they're atomic. The rest is only touched by whoever owns the node.
+   */
+  struct Waiter {
+    std::atomic<std::uint32_t> next;
+    std::atomic<Kind> kind;
+    std::coroutine_handle<> handle;
+    Executor* p_exec;
+    /// The sender's value, or the receiver's @c std::optional<T>.
+    void* p_slot;
+  };
+  static constexpr std::uint32_t NIL = UINT32_MAX;
+  /// The node count of the first segment.
+  static constexpr std::uint32_t FIRST_SEGMENT_SIZE = 64;
+  /// Enough for 2^31 nodes, so that no index reaches @ref NIL.
+  static constexpr std::size_t MAX_SEGMENTS = 25;
+
+  static constexpr auto index_of(std::uint64_t t_top) noexcept
+      -> std::uint32_t {
+    return static_cast<std::uint32_t>(t_top);
+  }
+  /// Bumps the tag of @p t_old_top, and points it to @p t_idx.
+  static constexpr auto make_top(std::uint64_t t_old_top,
+                                 std::uint32_t t_idx) noexcept
+      -> std::uint64_t {
+    constexpr auto TAG_SHIFT = 32U;
+    auto tag = (t_old_top >> TAG_SHIFT) + 1;
+    return (tag << TAG_SHIFT) | t_idx;
+  }
+  /// The index of the first node of segment @p t_seg.
+  static constexpr auto segment_start(std::size_t t_seg) noexcept
+      -> std::uint32_t {
+    return FIRST_SEGMENT_SIZE * ((std::uint32_t{1} << t_seg) - 1);
+  }
+
+  static_assert(std::uint64_t{FIRST_SEGMENT_SIZE} *
+                    ((std::uint64_t{1} << MAX_SEGMENTS) - 1) <
+                NIL);
+
+  auto node(std::uint32_t t_idx) noexcept -> Waiter&;
+  /**
+   * @brief Takes a free node.
+   * @return @a NIL if there's none.
+   */
+  auto pop_free() noexcept -> std::uint32_t;
+  /**
+   * @brief Gives back the nodes from @p t_first to @p t_last, already linked
+   * to each other.
+   */
+  void push_free(std::uint32_t t_first, std::uint32_t t_last) noexcept;
+  /**
+   * @brief Allocates a new segment, and frees all of its nodes but one.
+   * @return The one node not freed.
+   */
+  auto grow() noexcept -> std::uint32_t;
+  /**
+   * @brief Either parks the caller, or matches it with a waiter of the other
+   * kind.
+   * @param t_on_match Called with the matched waiter's @c p_slot.
+   * @return @c true if parked, so the caller must suspend.
+   */
+  template <typename OnMatch>
+  auto park_or_match(Kind t_kind, std::coroutine_handle<> t_handle,
+                     Executor* t_p_exec, void* t_p_slot,
+                     OnMatch&& t_on_match) noexcept -> bool;
+
+  std::array<std::atomic<Waiter*>, MAX_SEGMENTS> m_segments{};
+  /// How many segments were handed out, including ones still being set up.
+  std::atomic<std::size_t> m_segment_cnt{0};
+  /// Top of the waiter stack. Tag in the upper half, index in the lower.
+  std::atomic<std::uint64_t> m_top{NIL};
+  /// Top of the free node stack. Same layout as @ref m_top.
+  std::atomic<std::uint64_t> m_free{NIL};
+};
+
+template <typename T> class Channel<T>::SendAwaiter {
+public:
+  static auto await_ready() noexcept -> bool { return false; }
+  template <typename Promise>
+  auto await_suspend(std::coroutine_handle<Promise> t_handle) noexcept
+      -> bool {
+    return m_chan.park_or_match(
+        Kind::Send, t_handle, t_handle.promise().executor(), &m_value,
+        [this](void* t_p_slot) {
+          *static_cast<std::optional<T>*>(t_p_slot) = std::move(m_value);
+        });
+  }
+  static void await_resume() noexcept {}
+
+private:
+  friend class Channel;
+  SendAwaiter(Channel& t_chan, T&& t_value) noexcept
+      : m_chan(t_chan), m_value(std::move(t_value)) {}
+
+  Channel& m_chan; // NOLINT(*avoid-const-or-ref-data-members*)
+  T m_value;
+};
+
+template <typename T> class Channel<T>::ReceiveAwaiter {
+public:
+  static auto await_ready() noexcept -> bool { return false; }
+  template <typename Promise>
+  auto await_suspend(std::coroutine_handle<Promise> t_handle) noexcept
+      -> bool {
+    return m_chan.park_or_match(
+        Kind::Receive, t_handle, t_handle.promise().executor(), &m_value,
+        [this](void* t_p_slot) {
+          m_value.emplace(std::move(*static_cast<T*>(t_p_slot)));
+        });
+  }
+  auto await_resume() noexcept -> T { return std::move(*m_value); }
+
+private:
+  friend class Channel;
+  explicit ReceiveAwaiter(Channel& t_chan) noexcept : m_chan(t_chan) {}
+
+  Channel& m_chan; // NOLINT(*avoid-const-or-ref-data-members*)
+  std::optional<T> m_value{};
+};
+
+template <typename T> Channel<T>::~Channel() {
+  for (auto& segment : m_segments) {
+    // NOLINTNEXTLINE(*owning-memory*)
+    delete[] segment.load(std::memory_order::relaxed);
+  }
+}
+
+template <typename T>
+auto Channel<T>::node(std::uint32_t t_idx) noexcept -> Waiter& {
+  // segment s holds FIRST_SEGMENT_SIZE << s nodes.
+  auto seg = static_cast<std::size_t>(
+      std::bit_width(t_idx / FIRST_SEGMENT_SIZE + 1) - 1);
+  // whoever got hold of t_idx synchronized with the segment's creator, so
+  // the pointer is already there.
+  auto* p_segment = m_segments[seg].load(std::memory_order::acquire);
+  return p_segment[t_idx - segment_start(seg)];
+}
+
+template <typename T> auto Channel<T>::pop_free() noexcept -> std::uint32_t {
+  auto top = m_free.load(std::memory_order::acquire);
+  while (index_of(top) != NIL) {
+    auto next = node(index_of(top)).next.load(std::memory_order::relaxed);
+    if (m_free.compare_exchange_weak(top, make_top(top, next),
+                                     std::memory_order::acquire,
+                                     std::memory_order::acquire)) {
+      return index_of(top);
+    }
+  }
+  return NIL;
+}
+
+template <typename T>
+void Channel<T>::push_free(std::uint32_t t_first,
+                           std::uint32_t t_last) noexcept {
+  auto top = m_free.load(std::memory_order::relaxed);
+  do {
+    node(t_last).next.store(index_of(top), std::memory_order::relaxed);
+  } while (!m_free.compare_exchange_weak(top, make_top(top, t_first),
+                                         std::memory_order::release,
+                                         std::memory_order::relaxed));
+}
+
+template <typename T> auto Channel<T>::grow() noexcept -> std::uint32_t {
+  auto seg = m_segment_cnt.fetch_add(1, std::memory_order::relaxed);
+  if (seg >= MAX_SEGMENTS) {
+    // 2^31 coroutines waiting on one channel.
+    std::terminate();
+  }
+  auto cnt = FIRST_SEGMENT_SIZE << seg;
+  // on failure, this throws out of a noexcept function, and terminates.
+  auto* p_segment = new Waiter[cnt]{}; // NOLINT(*owning-memory*)
+  auto first = segment_start(seg);
+  for (std::uint32_t i = 1; i + 1 < cnt; ++i) {
+    p_segment[i].next.store(first + i + 1, std::memory_order::relaxed);
+  }
+  m_segments[seg].store(p_segment, std::memory_order::release);
+  if (cnt > 1) {
+    push_free(first + 1, first + cnt - 1);
+  }
+  return first;
+}
+
+template <typename T>
+template <typename OnMatch>
+auto Channel<T>::park_or_match(Kind t_kind, std::coroutine_handle<> t_handle,
+                               Executor* t_p_exec, void* t_p_slot,
+                               OnMatch&& t_on_match) noexcept -> bool {
+  auto own_idx = NIL;
+  auto top = m_top.load(std::memory_order::acquire);
+  while (true) {
+    auto top_idx = index_of(top);
+    // If the node got reused since we read top, the tag changed and the CAS
+    // below fails, so a stale kind or next is harmless.
+    if (top_idx == NIL ||
+        node(top_idx).kind.load(std::memory_order::relaxed) == t_kind) {
+      // nobody to meet. Park.
+      if (own_idx == NIL) {
+        own_idx = pop_free();
+        if (own_idx == NIL) {
+          own_idx = grow();
+        }
+        auto& own = node(own_idx);
+        own.handle = t_handle;
+        own.p_exec = t_p_exec;
+        own.p_slot = t_p_slot;
+        own.kind.store(t_kind, std::memory_order::relaxed);
+      }
+      node(own_idx).next.store(top_idx, std::memory_order::relaxed);
+      if (m_top.compare_exchange_weak(top, make_top(top, own_idx),
+                                      std::memory_order::acq_rel,
+                                      std::memory_order::acquire)) {
+        // someone may resume us as soon as the CAS lands. Don't touch
+        // anything after this.
+        return true;
+      }
+      continue;
+    }
+    // a waiter of the other kind. Take it off the stack.
+    auto next = node(top_idx).next.load(std::memory_order::relaxed);
+    if (!m_top.compare_exchange_weak(top, make_top(top, next),
+                                     std::memory_order::acq_rel,
+                                     std::memory_order::acquire)) {
+      continue;
+    }
+    if (own_idx != NIL) {
+      push_free(own_idx, own_idx);
+    }
+    auto& other = node(top_idx);
+    std::forward<OnMatch>(t_on_match)(other.p_slot);
+    auto other_handle = other.handle;
+    auto* p_other_exec = other.p_exec;
+    push_free(top_idx, top_idx);
+    p_other_exec->schedule(other_handle);
+    return false;
+  }
+}
+}
+
+#endif // !TSDS_CHANNEL_HPP
@@ -0,0 +1,23 @@
+#ifdef TSDS_MODULE
+
+/**
+ * @module tsds.executor
+ * @brief Defines a single-threaded and a thread pool executor for coroutines.
+ * @see tsds::SingleThreadExecutor
+ * @see tsds::ThreadPoolExecutor
+ */
+
+module;
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+export module tsds.executor;
+import tsds.mpmc_queue;
+import tsds.task;
+
+#include "executor.hpp"
+#endif
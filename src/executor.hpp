@@ -0,0 +1,148 @@
+/**
+ * @file executor.hpp
+ * @brief Contains definitions of @ref tsds::SingleThreadExecutor and
+ * @ref tsds::ThreadPoolExecutor.
+ */
+
+#ifndef TSDS_EXECUTOR_HPP
+#define TSDS_EXECUTOR_HPP
+
+#ifndef TSDS_MODULE
+#include "mpmc_queue.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#endif // !TSDS_MODULE
+
+#ifdef TSDS_MODULE
+export namespace tsds {
+#else
+namespace tsds {
+#endif // !TSDS_MODULE
+
+/**
+ * @class SingleThreadExecutor
+ * @brief Runs every coroutine on the thread that calls @ref run.
+ * @tparam QueueSize How many coroutines can be ready at once. Must be a power
+ * of 2.
+ *
+ * @ref schedule must only be called from the thread that calls @ref run. If
+ * the ready queue is full, the coroutine is resumed right away instead.
+ */
+template <std::size_t QueueSize = 1024>
+class SingleThreadExecutor final : public Executor {
+public:
+  void schedule(std::coroutine_handle<> t_handle) noexcept override {
+    if (!m_ready.try_push(std::move(t_handle))) {
+      t_handle.resume();
+    }
+  }
+  /**
+   * @brief Resumes ready coroutines until there are none left.
+   */
+  void run() noexcept {
+    while (auto handle = m_ready.try_pop()) {
+      handle->resume();
+    }
+  }
+
+private:
+  MpmcQueue<std::coroutine_handle<>, QueueSize> m_ready{};
+};
+
+/**
+ * @class ThreadPoolExecutor
+ * @brief Runs coroutines on a fixed number of threads, sharing one lock-free
+ * ready queue.
+ * @tparam QueueSize How many coroutines can be ready at once. Must be a power
+ * of 2.
+ *
+ * Idle threads sleep on an atomic counter bumped by every @ref schedule.
+ * Nobody sleeping means nothing to wake, so a busy pool doesn't make any
+ * syscall for scheduling.
+ *
+ * If the ready queue is full, the coroutine is resumed right away on the
+ * calling thread instead, the same as @ref SingleThreadExecutor. Waiting for
+ * room could hang, say, when spawning before @ref run, with nobody to pop.
+ */
+template <std::size_t QueueSize = 1024>
+class ThreadPoolExecutor final : public Executor {
+public:
+  /**
+   * @param t_thread_cnt Number of threads @ref run uses, counting the calling
+   * thread. Clamped to at least 1.
+   */
+  explicit ThreadPoolExecutor(std::size_t t_thread_cnt) noexcept
+      : m_thread_cnt(std::max<std::size_t>(1, t_thread_cnt)) {}
+
+  void schedule(std::coroutine_handle<> t_handle) noexcept override {
+    if (!m_ready.try_push(std::move(t_handle))) {
+      t_handle.resume();
+      return;
+    }
+    m_signal.fetch_add(1, std::memory_order::release);
+    m_signal.notify_one();
+  }
+  /**
+   * @brief Runs coroutines until every spawned @ref Task has finished.
+   */
+  void run();
+
+protected:
+  void on_idle() noexcept override {
+    m_signal.fetch_add(1, std::memory_order::release);
+    m_signal.notify_all();
+  }
+
+private:
+  void work() noexcept;
+
+  MpmcQueue<std::coroutine_handle<>, QueueSize> m_ready{};
+  std::atomic<std::uint32_t> m_signal{};
+  std::size_t m_thread_cnt;
+};
+
+template <std::size_t QueueSize>
+void ThreadPoolExecutor<QueueSize>::run() {
+  std::vector<std::thread> workers{};
+  workers.reserve(m_thread_cnt - 1);
+  for (std::size_t i = 1; i < m_thread_cnt; ++i) {
+    workers.emplace_back([this]() { work(); });
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+template <std::size_t QueueSize>
+void ThreadPoolExecutor<QueueSize>::work() noexcept {
+  while (true) {
+    if (auto handle = m_ready.try_pop()) {
+      handle->resume();
+      continue;
+    }
+    if (live() == 0) {
+      return;
+    }
+    // read the signal before checking again, so a schedule or a finish that
+    // slips in between is not missed by the wait below.
+    auto signal = m_signal.load(std::memory_order::acquire);
+    if (auto handle = m_ready.try_pop()) {
+      handle->resume();
+      continue;
+    }
+    if (live() == 0) {
+      return;
+    }
+    m_signal.wait(signal, std::memory_order::acquire);
+  }
+}
+}
+
+#endif // !TSDS_EXECUTOR_HPP
@@ -0,0 +1,20 @@
+#ifdef TSDS_MODULE
+
+/**
+ * @module tsds.mpmc_queue
+ * @brief Defines a bounded, lock-free MPMC queue.
+ * @see tsds::MpmcQueue
+ */
+
+module;
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <utility>
+export module tsds.mpmc_queue;
+
+#include "mpmc_queue.hpp"
+#endif
@@ -0,0 +1,138 @@
+/**
+ * @file mpmc_queue.hpp
+ * @brief Contains definitions of @ref tsds::MpmcQueue.
+ */
+
+#ifndef TSDS_MPMC_QUEUE_HPP
+#define TSDS_MPMC_QUEUE_HPP
+
+#ifndef TSDS_MODULE
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#endif // !TSDS_MODULE
+
+#ifdef TSDS_MODULE
+export namespace tsds {
+#else
+namespace tsds {
+#endif // !TSDS_MODULE
+
+/**
+ * @class MpmcQueue
+ * @brief A bounded, lock-free, multi-producer multi-consumer FIFO queue.
+ * @tparam T The element type. Must be default constructible.
+ * @tparam Capacity The maximum number of elements. Must be a power of 2.
+ *
+ * Each cell carries a sequence number telling whether it's ready to be
+ * written or read for the current lap around the ring. So, a push or a pop
+ * is one CAS on the shared position, plus a store on the cell.
+ *
+ * Neither @ref try_push nor @ref try_pop ever blocks: they fail right away if
+ * the queue is full or empty.
+ */
+template <typename T, std::size_t Capacity>
+  requires(std::has_single_bit(Capacity) &&
+           std::is_default_constructible_v<T>)
+class MpmcQueue {
+public:
+  MpmcQueue() noexcept {
+    for (std::size_t i = 0; i < Capacity; ++i) {
+      m_cells[i].seq.store(i, std::memory_order::relaxed);
+    }
+  }
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue(MpmcQueue&&) = delete;
+  auto operator=(const MpmcQueue&) = delete;
+  auto operator=(MpmcQueue&&) = delete;
+  ~MpmcQueue() = default;
+
+  /**
+   * @brief Pushes @p t_value to the back of the queue.
+   * @return @c false if the queue is full. @p t_value is untouched then.
+   */
+  auto try_push(T&& t_value) noexcept(std::is_nothrow_move_assignable_v<T>)
+      -> bool;
+  /**
+   * @brief Pops the front of the queue.
+   * @return @c std::nullopt if the queue is empty.
+   */
+  auto try_pop() noexcept(std::is_nothrow_move_constructible_v<T>)
+      -> std::optional<T>;
+
+private:
+  static constexpr std::size_t MASK = Capacity - 1;
+  /// Keeps the two positions off each other's cache line.
+  static constexpr std::size_t CACHE_LINE = 64;
+  struct Cell {
+    std::atomic<std::size_t> seq;
+    T data;
+  };
+  /// How far @p t_seq is ahead of @p t_pos.
+  static constexpr auto seq_diff(std::size_t t_seq, std::size_t t_pos) noexcept
+      -> std::ptrdiff_t {
+    return static_cast<std::ptrdiff_t>(t_seq - t_pos);
+  }
+
+  std::array<Cell, Capacity> m_cells{};
+  alignas(CACHE_LINE) std::atomic<std::size_t> m_enqueue_pos{};
+  alignas(CACHE_LINE) std::atomic<std::size_t> m_dequeue_pos{};
+};
+
+template <typename T, std::size_t Capacity>
+  requires(std::has_single_bit(Capacity) &&
+           std::is_default_constructible_v<T>)
+auto MpmcQueue<T, Capacity>::try_push(T&& t_value) noexcept(
+    std::is_nothrow_move_assignable_v<T>) -> bool {
+  auto pos = m_enqueue_pos.load(std::memory_order::relaxed);
+  while (true) {
+    auto& cell = m_cells[pos & MASK];
+    auto diff = seq_diff(cell.seq.load(std::memory_order::acquire), pos);
+    if (diff == 0) {
+      // the cell is free for this lap. Claim it.
+      if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order::relaxed)) {
+        cell.data = std::move(t_value);
+        cell.seq.store(pos + 1, std::memory_order::release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // the cell still holds an element from the last lap.
+      return false;
+    } else {
+      pos = m_enqueue_pos.load(std::memory_order::relaxed);
+    }
+  }
+}
+
+template <typename T, std::size_t Capacity>
+  requires(std::has_single_bit(Capacity) &&
+           std::is_default_constructible_v<T>)
+auto MpmcQueue<T, Capacity>::try_pop() noexcept(
+    std::is_nothrow_move_constructible_v<T>) -> std::optional<T> {
+  auto pos = m_dequeue_pos.load(std::memory_order::relaxed);
+  while (true) {
+    auto& cell = m_cells[pos & MASK];
+    auto diff = seq_diff(cell.seq.load(std::memory_order::acquire), pos + 1);
+    if (diff == 0) {
+      if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order::relaxed)) {
+        std::optional<T> ret{std::move(cell.data)};
+        // ready to be written on the next lap.
+        cell.seq.store(pos + Capacity, std::memory_order::release);
+        return ret;
+      }
+    } else if (diff < 0) {
+      return std::nullopt;
+    } else {
+      pos = m_dequeue_pos.load(std::memory_order::relaxed);
+    }
+  }
+}
+}
+
+#endif // !TSDS_MPMC_QUEUE_HPP
@@ -0,0 +1,27 @@
+#ifdef TSDS_MODULE
+
+/**
+ * @module tsds.persistent_arena_alloc
+ * @brief Defines an arena allocator backed by a memory-mapped file.
+ * @see tsds::PersistentArenaAlloc
+ */
+
+module;
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+export module tsds.persistent_arena_alloc;
+import tsds.arena_alloc;
+
+#include "persistent_arena_alloc.hpp"
+#endif
@@ -0,0 +1,242 @@
+/**
+ * @file persistent_arena_alloc.hpp
+ * @brief Contains definitions of @ref tsds::PersistentArenaAlloc.
+ */
+
+#ifndef TSDS_PERSISTENT_ARENA_ALLOC_HPP
+#define TSDS_PERSISTENT_ARENA_ALLOC_HPP
+
+#ifndef TSDS_MODULE
+#include "arena_alloc.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // !TSDS_MODULE
+
+#ifdef TSDS_MODULE
+export namespace tsds {
+#else
+namespace tsds {
+#endif // !TSDS_MODULE
+
+/**
+ * @class PersistentArenaAlloc
+ * @brief An @ref ArenaAlloc whose buffer is a memory-mapped file.
+ * @tparam Size The byte size of the buffer. The file is slightly larger, to
+ * hold a small header.
+ * @important POSIX only.
+ *
+ * The head index lives inside the file, next to the buffer. So, a process
+ * that opens the same file again resumes with everything it (or a previous
+ * process) allocated still in place.
+ *
+ * The file may be mapped at a different address each time. Anything stored
+ * inside the arena should refer to other things in the arena by offset; see
+ * @ref offset_of and @ref at.
+ *
+ * Allocation is thread-safe, the same way as @ref ArenaAlloc. Opening the
+ * same file from several processes at once is @b not supported.
+ */
+template <std::size_t Size>
+  requires ValidSize<Size>
+class PersistentArenaAlloc {
+public:
+  using AllocInfo = typename ArenaAlloc<Size>::AllocInfo;
+
+  /**
+   * @brief Opens, or creates, the arena file at @p t_path.
+   * @throw std::system_error if the file can't be opened or mapped, or if it
+   * is neither empty nor an arena file created with the same @a Size. Such a
+   * file is left untouched. A file of the right size with an all-zero header,
+   * as left by a crash while creating it, counts as empty.
+   */
+  explicit PersistentArenaAlloc(const std::filesystem::path& t_path);
+  PersistentArenaAlloc(const PersistentArenaAlloc&) = delete;
+  auto operator=(const PersistentArenaAlloc&) = delete;
+  PersistentArenaAlloc(PersistentArenaAlloc&& t_other) noexcept
+      : m_p_map(std::exchange(t_other.m_p_map, nullptr)) {}
+  auto operator=(PersistentArenaAlloc&& t_other) noexcept
+      -> PersistentArenaAlloc& {
+    if (this != &t_other) {
+      unmap();
+      m_p_map = std::exchange(t_other.m_p_map, nullptr);
+    }
+    return *this;
+  }
+  ~PersistentArenaAlloc() { unmap(); }
+
+  /**
+   * @copydoc tsds::ArenaAlloc::allocate
+   */
+  auto allocate(AllocInfo t_alloc_info) noexcept -> void*;
+  /**
+   * @brief Does nothing at all.
+   */
+  auto deallocate(void* /*unused*/) {}
+  /**
+   * @brief Flushes the mapping back to the file.
+   * @return @c true if successful.
+   *
+   * The kernel writes the pages back eventually anyways. Only call this if
+   * the data must survive a crash of the machine, not just of the process.
+   */
+  auto sync() noexcept -> bool {
+    return ::msync(m_p_map, MAP_SIZE, MS_SYNC) == 0;
+  }
+
+  /**
+   * @brief Turns a pointer into the arena into an offset that stays valid
+   * across restarts.
+   * @param t_ptr Must point into this arena.
+   */
+  [[nodiscard]] auto offset_of(const void* t_ptr) const noexcept
+      -> std::size_t {
+    return static_cast<std::size_t>(static_cast<const std::uint8_t*>(t_ptr) -
+                                    data());
+  }
+  /**
+   * @brief The opposite of @ref offset_of.
+   * @param t_offset Must have come from @ref offset_of, possibly in an
+   * earlier run.
+   */
+  template <typename T>
+  [[nodiscard]] auto at(std::size_t t_offset) const noexcept -> T* {
+    // NOLINTNEXTLINE(*reinterpret-cast*)
+    return reinterpret_cast<T*>(data() + t_offset);
+  }
+  /**
+   * @brief How many bytes of the buffer are taken, including padding.
+   */
+  [[nodiscard]] auto used() const noexcept -> std::size_t {
+    return head_idx().load(std::memory_order::acquire);
+  }
+
+private:
+  /**
+   * @class Header
+   * @brief Sits at the very start of the file.
+   */
+  struct Header {
+    /// @ref MAGIC once the file is initialized.
+    std::uint64_t magic;
+    /// @a Size the file was created with.
+    std::uint64_t size;
+    /// Same as @c m_head_idx of @ref ArenaAlloc.
+    alignas(std::atomic_ref<std::size_t>::required_alignment)
+        std::size_t head_idx;
+  };
+  static_assert(std::is_trivial_v<Header>);
+  static constexpr std::uint64_t MAGIC = 0x7473'6473'6172'656eULL; // "tsdsaren"
+  /// The buffer starts one cache line in, so the header doesn't share a line
+  /// with hot data.
+  static constexpr std::size_t DATA_OFFSET = 64;
+  static_assert(sizeof(Header) <= DATA_OFFSET);
+  static constexpr std::size_t MAP_SIZE = DATA_OFFSET + Size;
+
+  [[nodiscard]] auto header() const noexcept -> Header* {
+    return static_cast<Header*>(m_p_map);
+  }
+  [[nodiscard]] auto head_idx() const noexcept
+      -> std::atomic_ref<std::size_t> {
+    return std::atomic_ref<std::size_t>{header()->head_idx};
+  }
+  [[nodiscard]] auto data() const noexcept -> std::uint8_t* {
+    return static_cast<std::uint8_t*>(m_p_map) + DATA_OFFSET;
+  }
+  void unmap() noexcept {
+    if (m_p_map != nullptr) {
+      ::munmap(m_p_map, MAP_SIZE);
+      m_p_map = nullptr;
+    }
+  }
+
+  void* m_p_map{nullptr};
+};
+
+template <std::size_t Size>
+  requires ValidSize<Size>
+PersistentArenaAlloc<Size>::PersistentArenaAlloc(
+    const std::filesystem::path& t_path) {
+  // NOLINTNEXTLINE(*vararg*)
+  auto fd = ::open(t_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "open");
+  }
+  struct stat file_stat{};
+  if (::fstat(fd, &file_stat) != 0) {
+    auto err = errno;
+    ::close(fd);
+    throw std::system_error(err, std::generic_category(), "fstat");
+  }
+  // Only a file we just created, or an empty one, is ours to initialize.
+  // Anything else must already be an arena of this size; don't touch it
+  // otherwise.
+  auto fresh = file_stat.st_size == 0;
+  if (fresh) {
+    if (::ftruncate(fd, static_cast<off_t>(MAP_SIZE)) != 0) {
+      auto err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), "ftruncate");
+    }
+  } else if (static_cast<std::size_t>(file_stat.st_size) < MAP_SIZE) {
+    ::close(fd);
+    throw std::system_error(std::make_error_code(std::errc::invalid_argument),
+                            "not an arena file of this size");
+  }
+  auto* p_map =
+      ::mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  auto map_err = errno;
+  // the mapping keeps its own reference to the file.
+  ::close(fd);
+  // NOLINTNEXTLINE(*cstyle-cast*, *int-to-ptr*)
+  if (p_map == MAP_FAILED) {
+    throw std::system_error(map_err, std::generic_category(), "mmap");
+  }
+  m_p_map = p_map;
+
+  auto magic = std::atomic_ref<std::uint64_t>{header()->magic};
+  // a crash right after the ftruncate above leaves a file of the right size,
+  // with nothing written yet. That's still ours.
+  if (!fresh && static_cast<std::size_t>(file_stat.st_size) == MAP_SIZE &&
+      magic.load(std::memory_order::acquire) == 0 && header()->size == 0 &&
+      head_idx().load(std::memory_order::relaxed) == 0) {
+    fresh = true;
+  }
+  if (!fresh) {
+    if (magic.load(std::memory_order::acquire) != MAGIC ||
+        header()->size != Size) {
+      unmap();
+      throw std::system_error(std::make_error_code(std::errc::invalid_argument),
+                              "not an arena file of this size");
+    }
+    return;
+  }
+  // fresh file. ftruncate zero-fills, so head_idx is already 0.
+  header()->size = Size;
+  head_idx().store(0, std::memory_order::relaxed);
+  magic.store(MAGIC, std::memory_order::release);
+}
+
+template <std::size_t Size>
+  requires ValidSize<Size>
+auto PersistentArenaAlloc<Size>::allocate(AllocInfo t_alloc_info) noexcept
+    -> void* {
+  // The mapping is page-aligned, so aligning the address is the same as
+  // aligning the offset, and stays so across restarts.
+  auto head = head_idx();
+  return detail::arena_bump(data(), Size, head, t_alloc_info.size,
+                            t_alloc_info.align);
+}
+}
+
+#endif // !TSDS_PERSISTENT_ARENA_ALLOC_HPP
@@ -0,0 +1,23 @@
+#ifdef TSDS_MODULE
+
+/**
+ * @module tsds.sharded_arena_alloc
+ * @brief Defines a per-CPU sharded arena allocator.
+ * @see tsds::ShardedArenaAlloc
+ */
+
+module;
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <sched.h>
+#endif // __linux__
+export module tsds.sharded_arena_alloc;
+import tsds.arena_alloc;
+
+#include "sharded_arena_alloc.hpp"
+#endif
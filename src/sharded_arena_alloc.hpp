@@ -0,0 +1,123 @@
+/**
+ * @file sharded_arena_alloc.hpp
+ * @brief Contains definitions of @ref tsds::ShardedArenaAlloc.
+ */
+
+#ifndef TSDS_SHARDED_ARENA_ALLOC_HPP
+#define TSDS_SHARDED_ARENA_ALLOC_HPP
+
+#ifndef TSDS_MODULE
+#include "arena_alloc.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <sched.h>
+#endif // __linux__
+#endif // !TSDS_MODULE
+
+#ifdef TSDS_MODULE
+export namespace tsds {
+#else
+namespace tsds {
+#endif // !TSDS_MODULE
+
+/**
+ * @class ShardedArenaAlloc
+ * @brief An arena allocator with one bump region per CPU.
+ * @tparam Size The byte size of @b each shard's buffer.
+ * @tparam BuffInitAlloc Same as in @ref ArenaAlloc.
+ *
+ * Holds one @ref ArenaAlloc per hardware thread, and picks the shard of the
+ * CPU the calling thread currently runs on. So, memory use scales with the
+ * core count, not the thread count, and threads rarely contend on the same
+ * head index.
+ *
+ * Nothing stops a thread from being migrated between picking a shard and
+ * bumping its head. That's fine: each shard still bumps with a CAS, so the
+ * worst case is a bit of contention with whoever runs on that CPU now.
+ *
+ * If the picked shard is full, the other shards are tried in order before
+ * giving up.
+ */
+template <std::size_t Size,
+          template <typename> typename BuffInitAlloc = std::allocator>
+  requires ValidSize<Size>
+class ShardedArenaAlloc {
+public:
+  using ShardType = ArenaAlloc<Size, BuffInitAlloc>;
+  using AllocInfo = typename ShardType::AllocInfo;
+
+  /**
+   * @brief Constructs one shard per hardware thread.
+   */
+  ShardedArenaAlloc()
+      : ShardedArenaAlloc(std::max(1U, std::thread::hardware_concurrency())) {}
+  /**
+   * @brief Constructs @p t_shard_cnt shards.
+   * @param t_shard_cnt Clamped to at least 1.
+   */
+  explicit ShardedArenaAlloc(std::size_t t_shard_cnt)
+      : m_shards(std::max<std::size_t>(1, t_shard_cnt)) {}
+
+  /**
+   * @copydoc tsds::ArenaAlloc::allocate
+   * @return @c nullptr only if every shard is full.
+   */
+  auto allocate(AllocInfo t_alloc_info) noexcept -> void*;
+  /**
+   * @brief Does nothing at all.
+   */
+  auto deallocate(void* /*unused*/) {}
+  /**
+   * @brief The number of shards.
+   */
+  [[nodiscard]] auto shard_count() const noexcept -> std::size_t {
+    return m_shards.size();
+  }
+
+private:
+  /**
+   * @brief The CPU the calling thread runs on, or some per-thread number if
+   * the platform can't tell.
+   */
+  static auto current_cpu() noexcept -> std::size_t;
+
+  std::vector<ShardType> m_shards;
+};
+
+template <std::size_t Size, template <typename> typename BuffInitAlloc>
+  requires ValidSize<Size>
+auto ShardedArenaAlloc<Size, BuffInitAlloc>::current_cpu() noexcept
+    -> std::size_t {
+#if defined(__linux__)
+  // vDSO call, so this doesn't actually trap into the kernel.
+  auto cpu = ::sched_getcpu();
+  if (cpu >= 0) {
+    return static_cast<std::size_t>(cpu);
+  }
+#endif // __linux__
+  return std::hash<std::thread::id>{}(std::this_thread::get_id());
+}
+
+template <std::size_t Size, template <typename> typename BuffInitAlloc>
+  requires ValidSize<Size>
+auto ShardedArenaAlloc<Size, BuffInitAlloc>::allocate(
+    AllocInfo t_alloc_info) noexcept -> void* {
+  // cpu can be larger than the shard count, say, with CPU hotplug or a
+  // user-specified shard count.
+  auto start_idx = current_cpu() % m_shards.size();
+  for (std::size_t i = 0; i < m_shards.size(); ++i) {
+    auto& shard = m_shards[(start_idx + i) % m_shards.size()];
+    if (auto* ret = shard.allocate(t_alloc_info); ret != nullptr) {
+      return ret;
+    }
+  }
+  return nullptr;
+}
+}
+
+#endif // !TSDS_SHARDED_ARENA_ALLOC_HPP
@@ -0,0 +1,23 @@
+#ifdef TSDS_MODULE
+
+/**
+ * @module tsds.task
+ * @brief Defines a fire-and-forget coroutine type, and the executor interface
+ * it runs on.
+ * @see tsds::Task
+ * @see tsds::Executor
+ */
+
+module;
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <utility>
+export module tsds.task;
+
+#include "task.hpp"
+#endif
@@ -0,0 +1,266 @@
+/**
+ * @file task.hpp
+ * @brief Contains definitions of @ref tsds::Task and @ref tsds::Executor.
+ */
+
+#ifndef TSDS_TASK_HPP
+#define TSDS_TASK_HPP
+
+#ifndef TSDS_MODULE
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <utility>
+#endif // !TSDS_MODULE
+
+#ifdef TSDS_MODULE
+export namespace tsds {
+#else
+namespace tsds {
+#endif // !TSDS_MODULE
+
+class Task;
+
+/**
+ * @class Executor
+ * @brief Something that runs coroutines.
+ *
+ * Keeps count of the @ref Task spawned on it that haven't finished yet, so
+ * that a concrete executor knows when it's out of work.
+ */
+class Executor {
+public:
+  Executor() = default;
+  Executor(const Executor&) = delete;
+  Executor(Executor&&) = delete;
+  auto operator=(const Executor&) = delete;
+  auto operator=(Executor&&) = delete;
+  virtual ~Executor() = default;
+
+  /**
+   * @brief Queues @p t_handle to be resumed.
+   */
+  virtual void schedule(std::coroutine_handle<> t_handle) noexcept = 0;
+  /**
+   * @brief Hands @p t_task over to @c this, and schedules it.
+   */
+  void spawn(Task&& t_task) noexcept;
+  /**
+   * @brief Called by a @ref Task once it's done and its frame is freed.
+   */
+  void finish() noexcept {
+    if (m_live.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+      on_idle();
+    }
+  }
+
+protected:
+  /**
+   * @brief The number of spawned tasks that haven't finished yet.
+   */
+  [[nodiscard]] auto live() const noexcept -> std::size_t {
+    return m_live.load(std::memory_order::acquire);
+  }
+  /**
+   * @brief Called once the last live task finishes.
+   */
+  virtual void on_idle() noexcept {}
+
+private:
+  std::atomic<std::size_t> m_live{};
+};
+
+/**
+ * @class FrameBlock
+ * @brief A block type for a @ref PoolAlloc that holds coroutine frames.
+ * @tparam Size The byte size of one block. Must fit the frame, plus a
+ * 16-byte-ish header.
+ */
+template <std::size_t Size>
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) FrameBlock {
+  std::array<std::byte, Size> data;
+};
+
+/**
+ * @class Task
+ * @brief A fire-and-forget coroutine, started by @ref Executor::spawn.
+ *
+ * The frame can be allocated from a @ref PoolAlloc or @ref ArenaAlloc by
+ * taking @c std::allocator_arg and the allocator as the first two
+ * parameters:
+ * @code{.cpp}
+ * auto producer(std::allocator_arg_t, tsds::ArenaAlloc<4096>& alloc,
+ *               tsds::Channel<int>& chan) -> tsds::Task {
+ *   co_await chan.send(1);
+ * }
+ * @endcode
+ * The allocator must outlive the coroutine. If it can't give a large enough
+ * block, the frame falls back to @c ::operator new.
+ */
+class Task {
+public:
+  class promise_type; // NOLINT(*identifier-naming*)
+
+  Task(const Task&) = delete;
+  Task(Task&& t_other) noexcept
+      : m_handle(std::exchange(t_other.m_handle, nullptr)) {}
+  auto operator=(const Task&) = delete;
+  auto operator=(Task&& t_other) noexcept -> Task& {
+    if (this != &t_other) {
+      destroy();
+      m_handle = std::exchange(t_other.m_handle, nullptr);
+    }
+    return *this;
+  }
+  /**
+   * @brief Destroys the coroutine if it was never spawned.
+   */
+  ~Task() { destroy(); }
+
+private:
+  friend class Executor;
+  explicit Task(std::coroutine_handle<promise_type> t_handle) noexcept
+      : m_handle(t_handle) {}
+  void destroy() noexcept {
+    if (m_handle) {
+      m_handle.destroy();
+      m_handle = nullptr;
+    }
+  }
+
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+class Task::promise_type {
+public:
+  auto get_return_object() noexcept -> Task {
+    return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+  }
+  static auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+  static auto final_suspend() noexcept {
+    struct FinalAwaiter {
+      static auto await_ready() noexcept -> bool { return false; }
+      static void
+      await_suspend(std::coroutine_handle<promise_type> t_handle) noexcept {
+        auto* p_exec = t_handle.promise().m_p_exec;
+        // free the frame first, so that once the executor runs out of tasks,
+        // the frame allocators can be safely destroyed.
+        t_handle.destroy();
+        p_exec->finish();
+      }
+      static void await_resume() noexcept {}
+    };
+    return FinalAwaiter{};
+  }
+  static void return_void() noexcept {}
+  static void unhandled_exception() noexcept { std::terminate(); }
+
+  /**
+   * @brief The executor this task was spawned on.
+   */
+  [[nodiscard]] auto executor() const noexcept -> Executor* {
+    return m_p_exec;
+  }
+
+  /**
+   * @name Frame allocation
+   */
+  /// @{
+  static auto operator new(std::size_t t_size) -> void* {
+    return fallback_allocate(t_size);
+  }
+  /**
+   * The frame is freed by the usual @c operator delete; the header in front
+   * of it routes it back to @p t_alloc. GCC can't pair a template
+   * @c operator new with that, and warns with -Wmismatched-new-delete in
+   * every caller. So this is forced inline, leaving no @c operator new call
+   * for it to check.
+   */
+  template <typename Alloc, typename... Args>
+#ifdef __GNUC__
+  [[gnu::always_inline]]
+#endif // __GNUC__
+  static auto operator new(std::size_t t_size, std::allocator_arg_t /*unused*/,
+                           Alloc& t_alloc, Args&... /*unused*/) -> void* {
+    return allocate_with(t_size, t_alloc);
+  }
+  static void operator delete(void* t_ptr, std::size_t /*unused*/) noexcept {
+    auto* p_header = static_cast<FrameHeader*>(t_ptr) - 1;
+    p_header->dealloc(p_header->p_alloc, p_header);
+  }
+  /// @}
+
+private:
+  friend class Executor;
+  /**
+   * @class FrameHeader
+   * @brief Sits right before the frame, and remembers where the frame came
+   * from.
+   */
+  struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) FrameHeader {
+    void (*dealloc)(void* t_p_alloc, void* t_ptr) noexcept;
+    void* p_alloc;
+  };
+
+  template <typename Alloc>
+  static auto allocate_with(std::size_t t_size, Alloc& t_alloc) -> void*;
+  static auto fallback_allocate(std::size_t t_size) -> void* {
+    auto* p_header = static_cast<FrameHeader*>(
+        ::operator new(sizeof(FrameHeader) + t_size));
+    p_header->dealloc = [](void* /*unused*/, void* t_ptr) noexcept {
+      ::operator delete(t_ptr);
+    };
+    p_header->p_alloc = nullptr;
+    return p_header + 1;
+  }
+
+  Executor* m_p_exec{nullptr};
+};
+
+template <typename Alloc>
+auto Task::promise_type::allocate_with(std::size_t t_size, Alloc& t_alloc)
+    -> void* {
+  auto total = sizeof(FrameHeader) + t_size;
+  FrameHeader* p_header = nullptr;
+  if constexpr (requires { typename Alloc::AllocInfo; }) {
+    p_header = static_cast<FrameHeader*>(t_alloc.allocate(
+        {.size = total, .align = alignof(FrameHeader)}));
+    if (p_header != nullptr) {
+      p_header->dealloc = [](void* t_p_alloc, void* t_ptr) noexcept {
+        static_cast<Alloc*>(t_p_alloc)->deallocate(t_ptr);
+      };
+    }
+  } else {
+    using ValueType = typename Alloc::value_type;
+    if (sizeof(ValueType) >= total &&
+        alignof(ValueType) >= alignof(FrameHeader)) {
+      // NOLINTNEXTLINE(*reinterpret-cast*)
+      p_header = reinterpret_cast<FrameHeader*>(t_alloc.allocate());
+    }
+    if (p_header != nullptr) {
+      p_header->dealloc = [](void* t_p_alloc, void* t_ptr) noexcept {
+        static_cast<Alloc*>(t_p_alloc)->deallocate(
+            static_cast<typename Alloc::pointer>(t_ptr));
+      };
+    }
+  }
+  if (p_header == nullptr) {
+    return fallback_allocate(t_size);
+  }
+  p_header->p_alloc = &t_alloc;
+  return p_header + 1;
+}
+
+inline void Executor::spawn(Task&& t_task) noexcept {
+  auto handle = std::exchange(t_task.m_handle, nullptr);
+  handle.promise().m_p_exec = this;
+  m_live.fetch_add(1, std::memory_order::relaxed);
+  schedule(handle);
+}
+}
+
+#endif // !TSDS_TASK_HPP
@@ -10,5 +10,11 @@
 #ifdef TSDS_MODULE
 module;
 export module tsds;
+export import tsds.alloc_trace;
+export import tsds.channel;
+export import tsds.executor;
+export import tsds.mpmc_queue;
 export import tsds.pool_alloc;
+export import tsds.sharded_arena_alloc;
+export import tsds.task;
 #endif // TSDS_MODULE
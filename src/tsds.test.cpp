@@ -2,16 +2,45 @@
 // without the range, clangd complains. So, comment the include out when clangd
 // complains
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
 #include <thread>
+#ifndef _WIN32
+#include <unistd.h>
+#endif // !_WIN32
 #ifdef TSDS_MODULE
+import tsds.alloc_trace;
 import tsds.pool_alloc;
 import tsds.arena_alloc;
+import tsds.channel;
+import tsds.executor;
+import tsds.mpmc_queue;
+import tsds.task;
+import tsds.sharded_arena_alloc;
+#ifndef _WIN32
+import tsds.persistent_arena_alloc;
+#endif // !_WIN32
 #else
+#include "alloc_trace.hpp"
 #include "arena_alloc.hpp"
+#include "channel.hpp"
+#include "executor.hpp"
+#include "mpmc_queue.hpp"
 #include "pool_alloc.hpp"
+#ifndef _WIN32
+#include "persistent_arena_alloc.hpp"
+#endif // !_WIN32
+#include "sharded_arena_alloc.hpp"
 #endif // TSDS_MODULE
 
 // NOTE: Catch2 assertions are not thread-safe.
@@ -108,4 +137,327 @@ TEST(ArenaTest, ThreadTest) {
     }
   }
 }
+
+TEST(ShardedArenaTest, ThreadTest) {
+  tsds::ShardedArenaAlloc<4096> test{};      // NOLINT(*magic-number*)
+  ASSERT_GT(test.shard_count(), 0);
+  std::array<std::thread, 8> test_threads{}; // NOLINT(*magic-number*)
+  for (uint8_t i = 0; i < 8; ++i) {          // NOLINT(*magic-number*)
+    test_threads.at(i) = std::thread{[&]() mutable {
+      std::array<long*, 16> arr{};       // NOLINT(*magic-number*)
+      for (uint8_t j = 0; j < 16; ++j) { // NOLINT(*magic-number*)
+        auto* lnum = static_cast<long*>(
+            test.allocate({.size = sizeof(long), .align = alignof(long)}));
+        ASSERT_NE(lnum, nullptr);
+        *lnum = j + 97; // NOLINT(*magic-number*)
+        arr.at(j) = lnum;
+      }
+      for (uint8_t j = 0; j < 16; ++j) { // NOLINT(*magic-number*)
+        ASSERT_EQ(*arr.at(j), 97 + j);
+      }
+    }};
+  }
+  for (auto& thr : test_threads) {
+    if (thr.joinable()) {
+      thr.join();
+    }
+  }
+}
+
+TEST(ShardedArenaTest, SpillTest) {
+  // 2 shards of 64 bytes each. Whichever shard we start on, the other one
+  // should be used once it's full.
+  tsds::ShardedArenaAlloc<64> test{2}; // NOLINT(*magic-number*)
+  std::size_t cnt = 0;
+  while (test.allocate({.size = 16, .align = 16}) != nullptr) {
+    ++cnt;
+  }
+  // each shard fits at least 3 blocks of 16 bytes.
+  ASSERT_GE(cnt, 6);
+}
+
+TEST(ShardedArenaTest, ZeroShardTest) {
+  tsds::ShardedArenaAlloc<64> test{0}; // NOLINT(*magic-number*)
+  ASSERT_EQ(test.shard_count(), 1);
+  ASSERT_NE(test.allocate({.size = sizeof(int), .align = alignof(int)}),
+            nullptr);
+}
+
+#ifndef _WIN32
+TEST(PersistentArenaTest, ReopenTest) {
+  auto path = std::filesystem::temp_directory_path() /
+              ("tsds_persistent_arena_" + std::to_string(::getpid()));
+  std::filesystem::remove(path);
+  std::size_t offset{};
+  std::size_t used{};
+  {
+    tsds::PersistentArenaAlloc<4096> test{path}; // NOLINT(*magic-number*)
+    ASSERT_EQ(test.used(), 0);
+    auto* lnum = static_cast<long*>(
+        test.allocate({.size = sizeof(long), .align = alignof(long)}));
+    ASSERT_NE(lnum, nullptr);
+    *lnum = 97; // NOLINT(*magic-number*)
+    offset = test.offset_of(lnum);
+    used = test.used();
+    ASSERT_EQ(test.at<long>(offset), lnum);
+  }
+  {
+    tsds::PersistentArenaAlloc<4096> test{path}; // NOLINT(*magic-number*)
+    // everything allocated last time is still there.
+    ASSERT_EQ(test.used(), used);
+    ASSERT_EQ(*test.at<long>(offset), 97);
+    auto* num = static_cast<int*>(
+        test.allocate({.size = sizeof(int), .align = alignof(int)}));
+    ASSERT_NE(num, nullptr);
+    ASSERT_GE(test.offset_of(num), offset + sizeof(long));
+  }
+  // size mismatch
+  ASSERT_THROW(tsds::PersistentArenaAlloc<1024>{path}, // NOLINT(*magic-number*)
+               std::system_error);
+  ASSERT_THROW(tsds::PersistentArenaAlloc<8192>{path}, // NOLINT(*magic-number*)
+               std::system_error);
+  std::filesystem::remove(path);
+}
+
+TEST(PersistentArenaTest, HalfCreatedTest) {
+  auto path = std::filesystem::temp_directory_path() /
+              ("tsds_persistent_half_" + std::to_string(::getpid()));
+  std::filesystem::remove(path);
+  // what a crash right after sizing a new file leaves behind: the 64-byte
+  // header plus the buffer, all zeros.
+  {
+    std::ofstream out{path, std::ios::binary};
+  }
+  std::filesystem::resize_file(path, 64 + 4096); // NOLINT(*magic-number*)
+  {
+    tsds::PersistentArenaAlloc<4096> test{path}; // NOLINT(*magic-number*)
+    ASSERT_EQ(test.used(), 0);
+    ASSERT_NE(test.allocate({.size = sizeof(int), .align = alignof(int)}),
+              nullptr);
+  }
+  tsds::PersistentArenaAlloc<4096> test{path}; // NOLINT(*magic-number*)
+  ASSERT_NE(test.used(), 0);
+  std::filesystem::remove(path);
+}
+
+TEST(PersistentArenaTest, ForeignFileTest) {
+  auto path = std::filesystem::temp_directory_path() /
+              ("tsds_persistent_foreign_" + std::to_string(::getpid()));
+  const std::string content(8192, 'x'); // NOLINT(*magic-number*)
+  {
+    std::ofstream out{path, std::ios::binary};
+    out << content;
+  }
+  ASSERT_THROW(tsds::PersistentArenaAlloc<4096>{path}, // NOLINT(*magic-number*)
+               std::system_error);
+  // the file must be left as it was.
+  std::ifstream in{path, std::ios::binary};
+  std::string read_back((std::istreambuf_iterator<char>(in)),
+                        std::istreambuf_iterator<char>());
+  ASSERT_EQ(read_back, content);
+  std::filesystem::remove(path);
+}
+#endif // !_WIN32
+
+TEST(AllocTraceTest, RoundTripTest) {
+  using EventKind = tsds::AllocTrace::EventKind;
+  tsds::AllocTrace trace{64}; // NOLINT(*magic-number*)
+  tsds::TracedAlloc<tsds::PoolAlloc<long, 8>> pool{trace};
+  tsds::TracedAlloc<tsds::ArenaAlloc<256>> arena{trace};
+  auto* lnum = pool.allocate();
+  ASSERT_NE(lnum, nullptr);
+  auto* chr = arena.allocate({.size = sizeof(char), .align = alignof(char)});
+  ASSERT_NE(chr, nullptr);
+  pool.deallocate(lnum);
+  arena.deallocate(chr);
+
+  std::thread{[&]() {
+    auto* num = pool.allocate();
+    pool.deallocate(num);
+  }}.join();
+
+  std::stringstream strm{};
+  ASSERT_TRUE(trace.write(strm));
+  // magic, count, then the events with no padding.
+  ASSERT_EQ(strm.str().size(), 16 + 6 * tsds::AllocTrace::RECORD_SIZE);
+  auto evts = tsds::AllocTrace::read(strm);
+  ASSERT_TRUE(evts.has_value());
+  ASSERT_EQ(evts->size(), 6);
+  ASSERT_EQ(trace.dropped(), 0);
+
+  auto& alloc_evt = evts->at(0);
+  ASSERT_EQ(alloc_evt.kind, EventKind::Alloc);
+  ASSERT_EQ(alloc_evt.size, sizeof(long));
+  ASSERT_EQ(1U << alloc_evt.align_log2, alignof(long));
+  // the free pairs with its alloc by address.
+  ASSERT_EQ(evts->at(2).kind, EventKind::Free);
+  ASSERT_EQ(evts->at(2).addr, alloc_evt.addr);
+  ASSERT_EQ(evts->at(1).size, sizeof(char));
+  ASSERT_EQ(evts->at(3).addr, evts->at(1).addr);
+  // different thread, different id.
+  ASSERT_NE(evts->at(4).thread, alloc_evt.thread);
+  ASSERT_LE(alloc_evt.timestamp, evts->at(5).timestamp);
+
+  std::stringstream bad{"not a trace"};
+  ASSERT_FALSE(tsds::AllocTrace::read(bad).has_value());
+  // a count way past what the stream holds.
+  auto huge = strm.str();
+  constexpr std::uint64_t HUGE_CNT = 0x0fff'ffff'ffff'ffffULL;
+  std::memcpy(huge.data() + 8, &HUGE_CNT, sizeof(HUGE_CNT));
+  std::stringstream huge_strm{huge};
+  ASSERT_FALSE(tsds::AllocTrace::read(huge_strm).has_value());
+}
+
+TEST(MpmcQueueTest, ThreadTest) {
+  constexpr int PER_THREAD = 1000;
+  tsds::MpmcQueue<int, 64> test{};           // NOLINT(*magic-number*)
+  std::array<std::thread, 8> test_threads{}; // NOLINT(*magic-number*)
+  std::atomic<long> sum{0};
+  for (uint8_t i = 0; i < 8; ++i) { // NOLINT(*magic-number*)
+    // even threads push, odd threads pop.
+    test_threads.at(i) = std::thread{[&, i]() mutable {
+      for (int j = 1; j <= PER_THREAD; ++j) {
+        if (i % 2 == 0) {
+          while (!test.try_push(int{j})) {
+            std::this_thread::yield();
+          }
+          continue;
+        }
+        auto val = test.try_pop();
+        while (!val) {
+          std::this_thread::yield();
+          val = test.try_pop();
+        }
+        sum.fetch_add(*val);
+      }
+    }};
+  }
+  for (auto& thr : test_threads) {
+    if (thr.joinable()) {
+      thr.join();
+    }
+  }
+  ASSERT_EQ(sum.load(), 4L * PER_THREAD * (PER_THREAD + 1) / 2);
+  ASSERT_FALSE(test.try_pop().has_value());
+}
+
+namespace {
+template <typename Alloc>
+auto produce(std::allocator_arg_t /*unused*/, Alloc& /*unused*/,
+             tsds::Channel<int>& t_chan, int t_cnt) -> tsds::Task {
+  for (int i = 1; i <= t_cnt; ++i) {
+    co_await t_chan.send(i);
+  }
+}
+
+template <typename Alloc>
+auto consume(std::allocator_arg_t /*unused*/, Alloc& /*unused*/,
+             tsds::Channel<int>& t_chan, int t_cnt, std::atomic<long>& t_sum)
+    -> tsds::Task {
+  for (int i = 0; i < t_cnt; ++i) {
+    t_sum.fetch_add(co_await t_chan.receive());
+  }
+}
+} // namespace
+
+TEST(ChannelTest, SingleThreadTest) {
+  constexpr int CNT = 1000;
+  tsds::ArenaAlloc<4096> frames{}; // NOLINT(*magic-number*)
+  tsds::Channel<int> chan{};
+  std::atomic<long> sum{0};
+  tsds::SingleThreadExecutor<> exec{};
+  auto* p_before =
+      static_cast<std::byte*>(frames.allocate({.size = 1, .align = 1}));
+  exec.spawn(consume(std::allocator_arg, frames, chan, CNT, sum));
+  exec.spawn(produce(std::allocator_arg, frames, chan, CNT));
+  // both frames, each behind its header, came from the arena.
+  auto* p_after =
+      static_cast<std::byte*>(frames.allocate({.size = 1, .align = 1}));
+  ASSERT_NE(p_before, nullptr);
+  ASSERT_NE(p_after, nullptr);
+  ASSERT_GT(p_after - p_before,
+            static_cast<std::ptrdiff_t>(2 * __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+  exec.run();
+  ASSERT_EQ(sum.load(), long{CNT} * (CNT + 1) / 2);
+}
+
+TEST(ChannelTest, ThreadPoolTest) {
+  constexpr int CNT = 1000;
+  constexpr int PAIRS = 8;
+  // NOLINTNEXTLINE(*magic-number*)
+  tsds::PoolAlloc<tsds::FrameBlock<512>, 2 * PAIRS> frames{};
+  tsds::Channel<int> chan{};
+  std::atomic<long> sum{0};
+  tsds::ThreadPoolExecutor<> exec{4}; // NOLINT(*magic-number*)
+  for (int i = 0; i < PAIRS; ++i) {
+    exec.spawn(produce(std::allocator_arg, frames, chan, CNT));
+    exec.spawn(consume(std::allocator_arg, frames, chan, CNT, sum));
+  }
+  // every frame took a block.
+  ASSERT_EQ(frames.allocate(), nullptr);
+  exec.run();
+  ASSERT_EQ(sum.load(), long{PAIRS} * CNT * (CNT + 1) / 2);
+}
+
+TEST(ChannelTest, ManyWaitersTest) {
+  // all receivers park before any sender shows up.
+  constexpr int WAITERS = 100;
+  tsds::ArenaAlloc<std::size_t{1} << 16U> frames{};
+  tsds::Channel<int> chan{};
+  std::atomic<long> sum{0};
+  tsds::SingleThreadExecutor<> exec{};
+  for (int i = 0; i < WAITERS; ++i) {
+    exec.spawn(consume(std::allocator_arg, frames, chan, 1, sum));
+  }
+  exec.run();
+  for (int i = 0; i < WAITERS; ++i) {
+    exec.spawn(produce(std::allocator_arg, frames, chan, 1));
+  }
+  exec.run();
+  ASSERT_EQ(sum.load(), WAITERS);
+}
+
+TEST(ChannelTest, GrowThreadTest) {
+  // enough waiters at once for the channel to add node segments from
+  // several threads.
+  constexpr int WAITERS = 1000;
+  tsds::ArenaAlloc<std::size_t{1} << 20U> frames{};
+  tsds::Channel<int> chan{};
+  std::atomic<long> sum{0};
+  tsds::ThreadPoolExecutor<> exec{4}; // NOLINT(*magic-number*)
+  for (int i = 0; i < WAITERS; ++i) {
+    exec.spawn(consume(std::allocator_arg, frames, chan, 1, sum));
+    exec.spawn(consume(std::allocator_arg, frames, chan, 1, sum));
+    exec.spawn(produce(std::allocator_arg, frames, chan, 2));
+  }
+  exec.run();
+  ASSERT_EQ(sum.load(), long{WAITERS} * 3);
+}
+
+namespace {
+auto count_up(std::atomic<int>& t_cnt) -> tsds::Task {
+  t_cnt.fetch_add(1, std::memory_order::relaxed);
+  co_return;
+}
+} // namespace
+
+TEST(ExecutorTest, OverflowTest) {
+  constexpr int QUEUE_SIZE = 16;
+  std::atomic<int> cnt{0};
+  tsds::ThreadPoolExecutor<QUEUE_SIZE> exec{2};
+  // one more than fits, with nobody popping yet.
+  for (int i = 0; i < QUEUE_SIZE + 1; ++i) {
+    exec.spawn(count_up(cnt));
+  }
+  exec.run();
+  ASSERT_EQ(cnt.load(), QUEUE_SIZE + 1);
+}
+
+TEST(ExecutorTest, ZeroThreadTest) {
+  std::atomic<int> cnt{0};
+  tsds::ThreadPoolExecutor<> exec{0};
+  exec.spawn(count_up(cnt));
+  exec.run();
+  ASSERT_EQ(cnt.load(), 1);
+}
 // NOLINTEND(*function-cognitive-complexity*)
@@ -0,0 +1,690 @@
+/**
+ * @file tsds_replay.cpp
+ * @brief Replays a trace recorded by @ref tsds::AllocTrace against one
+ * allocator, and reports how it did.
+ *
+ * Usage:
+ * @code{.sh}
+ * tsds_replay <trace-file> [malloc|pmr|pool|arena] [--timed]
+ *             [--pool-blocks=N] [--arena-bytes=N]
+ * @endcode
+ *
+ * Each recorded thread's events run in recorded order on a replay thread.
+ * Recorded threads that never ran at the same time share a replay thread, one
+ * after another, so a trace of many short-lived threads doesn't need as many
+ * OS threads at once. A free of a block allocated by another thread waits until
+ * that thread's allocation is done, so cross-thread handoffs replay the same
+ * way they happened. With @c --timed, each event also waits until its
+ * recorded timestamp.
+ *
+ * @c --pool-blocks and @c --arena-bytes set the capacity of the tsds
+ * allocators. If more than 1% of the allocations fail, the allocator is
+ * reported as unusable for the trace, with exit code 2, instead of reporting
+ * numbers that mostly measure failures.
+ *
+ * Run one allocator per process: peak memory is the growth of the process'
+ * peak RSS over the replay, with the high-water mark reset right before the
+ * allocator is constructed (Linux only). The pool and the arena also report
+ * the bytes they reserve up front.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <sstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif // __GLIBC__
+
+#ifdef TSDS_MODULE
+import tsds.alloc_trace;
+import tsds.arena_alloc;
+import tsds.pool_alloc;
+#else
+#include "alloc_trace.hpp"
+#include "arena_alloc.hpp"
+#include "pool_alloc.hpp"
+#endif // TSDS_MODULE
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using EventKind = tsds::AllocTrace::EventKind;
+
+/**
+ * @class Allocation
+ * @brief A block handed out by a @ref Resource.
+ */
+struct Allocation {
+  void* ptr;
+  /// Which chunk of a chunked resource the block came from.
+  std::size_t chunk;
+};
+
+/**
+ * @class Resource
+ * @brief The bit of an allocator the replay needs.
+ */
+class Resource {
+public:
+  Resource() = default;
+  Resource(const Resource&) = delete;
+  Resource(Resource&&) = delete;
+  auto operator=(const Resource&) = delete;
+  auto operator=(Resource&&) = delete;
+  virtual ~Resource() = default;
+  /**
+   * @return A @c nullptr block on failure.
+   */
+  virtual auto allocate(std::size_t t_size, std::size_t t_align)
+      -> Allocation = 0;
+  virtual void deallocate(Allocation t_block, std::size_t t_size,
+                          std::size_t t_align) = 0;
+  /**
+   * @brief Bytes set aside up front, if the allocator does that.
+   */
+  [[nodiscard]] virtual auto reserved() const -> std::optional<std::size_t> {
+    return std::nullopt;
+  }
+};
+
+class MallocResource final : public Resource {
+public:
+  auto allocate(std::size_t t_size, std::size_t t_align)
+      -> Allocation override {
+    if (t_align <= alignof(std::max_align_t)) {
+      // NOLINTNEXTLINE(*no-malloc*, *owning-memory*)
+      return {.ptr = std::malloc(t_size), .chunk = 0};
+    }
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    return {.ptr = std::aligned_alloc(t_align,
+                                      (t_size + t_align - 1) & ~(t_align - 1)),
+            .chunk = 0};
+  }
+  void deallocate(Allocation t_block, std::size_t /*unused*/,
+                  std::size_t /*unused*/) override {
+    std::free(t_block.ptr); // NOLINT(*no-malloc*, *owning-memory*)
+  }
+};
+
+class PmrResource final : public Resource {
+public:
+  auto allocate(std::size_t t_size, std::size_t t_align)
+      -> Allocation override {
+    return {.ptr = m_res.allocate(t_size, t_align), .chunk = 0};
+  }
+  void deallocate(Allocation t_block, std::size_t t_size,
+                  std::size_t t_align) override {
+    m_res.deallocate(t_block.ptr, t_size, t_align);
+  }
+
+private:
+  std::pmr::synchronized_pool_resource m_res{};
+};
+
+/**
+ * @class ChunkedResource
+ * @brief Spreads a runtime capacity over fixed-size allocators, since the
+ * tsds allocators take their size as a template parameter.
+ * @tparam Alloc Default constructible, one chunk's worth of capacity.
+ *
+ * Allocates from the current chunk, and moves on to the next one that has
+ * room once it's full.
+ */
+template <typename Alloc> class ChunkedResource : public Resource {
+public:
+  explicit ChunkedResource(std::size_t t_chunk_cnt)
+      : m_chunks(std::max<std::size_t>(1, t_chunk_cnt)) {}
+
+protected:
+  template <typename AllocOne>
+  auto allocate_chunked(AllocOne&& t_alloc_one) -> Allocation {
+    auto start = m_curr.load(std::memory_order::relaxed);
+    for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+      auto idx = (start + i) % m_chunks.size();
+      if (void* ptr = t_alloc_one(m_chunks[idx]); ptr != nullptr) {
+        if (i != 0) {
+          m_curr.store(idx, std::memory_order::relaxed);
+        }
+        return {.ptr = ptr, .chunk = idx};
+      }
+    }
+    return {.ptr = nullptr, .chunk = 0};
+  }
+  auto chunk(std::size_t t_idx) -> Alloc& { return m_chunks[t_idx]; }
+  [[nodiscard]] auto chunk_count() const -> std::size_t {
+    return m_chunks.size();
+  }
+
+private:
+  std::vector<Alloc> m_chunks;
+  std::atomic<std::size_t> m_curr{0};
+};
+
+/**
+ * @brief Every request up to this size and alignment is served by one pool
+ * block. Anything larger fails.
+ */
+struct alignas(64) PoolBlock {
+  std::array<std::byte, 256> data; // NOLINT(*magic-number*)
+};
+constexpr std::size_t POOL_CHUNK_BLOCKS = 4096;
+using PoolChunk = tsds::PoolAlloc<PoolBlock, POOL_CHUNK_BLOCKS>;
+
+class PoolResource final : public ChunkedResource<PoolChunk> {
+public:
+  explicit PoolResource(std::size_t t_block_cnt)
+      : ChunkedResource((t_block_cnt + POOL_CHUNK_BLOCKS - 1) /
+                        POOL_CHUNK_BLOCKS) {}
+  auto allocate(std::size_t t_size, std::size_t t_align)
+      -> Allocation override {
+    if (t_size > sizeof(PoolBlock) || t_align > alignof(PoolBlock)) {
+      return {.ptr = nullptr, .chunk = 0};
+    }
+    return allocate_chunked(
+        [](PoolChunk& t_chunk) -> void* { return t_chunk.allocate(); });
+  }
+  void deallocate(Allocation t_block, std::size_t /*unused*/,
+                  std::size_t /*unused*/) override {
+    chunk(t_block.chunk).deallocate(static_cast<PoolBlock*>(t_block.ptr));
+  }
+  [[nodiscard]] auto reserved() const -> std::optional<std::size_t> override {
+    return chunk_count() * POOL_CHUNK_BLOCKS * sizeof(PoolBlock);
+  }
+};
+
+/// Also the largest single request the arena can serve.
+constexpr std::size_t ARENA_CHUNK_BYTES = std::size_t{1} << 24U;
+using ArenaChunk = tsds::ArenaAlloc<ARENA_CHUNK_BYTES>;
+
+class ArenaResource final : public ChunkedResource<ArenaChunk> {
+public:
+  explicit ArenaResource(std::size_t t_bytes)
+      : ChunkedResource((t_bytes + ARENA_CHUNK_BYTES - 1) / ARENA_CHUNK_BYTES) {
+  }
+  auto allocate(std::size_t t_size, std::size_t t_align)
+      -> Allocation override {
+    return allocate_chunked([&](ArenaChunk& t_chunk) {
+      return t_chunk.allocate({.size = t_size, .align = t_align});
+    });
+  }
+  void deallocate(Allocation t_block, std::size_t /*unused*/,
+                  std::size_t /*unused*/) override {
+    chunk(t_block.chunk).deallocate(t_block.ptr);
+  }
+  [[nodiscard]] auto reserved() const -> std::optional<std::size_t> override {
+    return chunk_count() * ARENA_CHUNK_BYTES;
+  }
+};
+
+/**
+ * @class Options
+ * @brief What's on the command line.
+ */
+struct Options {
+  std::string_view trace_path;
+  std::string_view alloc_name{"malloc"};
+  bool timed{false};
+  /// Rounded up to a multiple of @ref POOL_CHUNK_BLOCKS.
+  std::size_t pool_blocks{std::size_t{1} << 16U};
+  /// Rounded up to a multiple of @ref ARENA_CHUNK_BYTES.
+  std::size_t arena_bytes{std::size_t{1} << 26U};
+};
+
+constexpr std::array<std::string_view, 4> ALLOC_NAMES{"malloc", "pmr", "pool",
+                                                     "arena"};
+
+auto make_resource(const Options& t_opts) -> std::unique_ptr<Resource> {
+  if (t_opts.alloc_name == "malloc") {
+    return std::make_unique<MallocResource>();
+  }
+  if (t_opts.alloc_name == "pmr") {
+    return std::make_unique<PmrResource>();
+  }
+  if (t_opts.alloc_name == "pool") {
+    return std::make_unique<PoolResource>(t_opts.pool_blocks);
+  }
+  if (t_opts.alloc_name == "arena") {
+    return std::make_unique<ArenaResource>(t_opts.arena_bytes);
+  }
+  return nullptr;
+}
+
+/**
+ * @class Op
+ * @brief An event, with its address replaced by a dense block id.
+ */
+struct Op {
+  std::uint64_t timestamp;
+  std::size_t block;
+  std::size_t size;
+  std::size_t align;
+  EventKind kind;
+};
+
+/**
+ * @class Block
+ * @brief Where a replayed allocation ended up.
+ */
+struct Block {
+  /// Only read once @c done is set.
+  Allocation alloc{.ptr = nullptr, .chunk = 0};
+  /// Set once the allocation has been replayed, even if it failed.
+  std::atomic<bool> done{false};
+};
+
+/**
+ * @class Replay
+ * @brief A trace split into per-thread op lists.
+ */
+struct Replay {
+  /// The ops of each recorded thread that has any, renumbered densely.
+  std::vector<std::vector<Op>> threads;
+  /// The recorded threads each replay thread runs, one after another.
+  std::vector<std::vector<std::size_t>> lanes;
+  std::size_t block_cnt{};
+  std::size_t peak_live_bytes{};
+};
+
+/**
+ * @brief Packs recorded threads whose ops never overlapped in time into the
+ * same replay thread.
+ *
+ * Greedy interval partitioning, so there are as many replay threads as
+ * recorded threads ever ran at once, not as many as ever existed.
+ *
+ * A free never waits for a later alloc, and each replay thread runs its ops
+ * in timestamp order. So, replaying a lane can't deadlock on itself, nor on
+ * the other lanes.
+ */
+auto assign_lanes(const std::vector<std::vector<Op>>& t_threads)
+    -> std::vector<std::vector<std::size_t>> {
+  std::vector<std::size_t> order(t_threads.size());
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::ranges::sort(order, {}, [&](std::size_t t_thr) {
+    return t_threads[t_thr].front().timestamp;
+  });
+  std::vector<std::vector<std::size_t>> ret{};
+  // (timestamp of the last op, lane), earliest free lane on top.
+  using LaneEnd = std::pair<std::uint64_t, std::size_t>;
+  std::priority_queue<LaneEnd, std::vector<LaneEnd>, std::greater<>> ends{};
+  for (auto thr : order) {
+    const auto& ops = t_threads[thr];
+    std::size_t lane{};
+    if (!ends.empty() && ends.top().first < ops.front().timestamp) {
+      lane = ends.top().second;
+      ends.pop();
+    } else {
+      lane = ret.size();
+      ret.emplace_back();
+    }
+    ret[lane].push_back(thr);
+    ends.emplace(ops.back().timestamp, lane);
+  }
+  return ret;
+}
+
+/**
+ * @brief Pairs frees with allocs by address, and splits the ops by thread.
+ *
+ * Frees of addresses that were never seen allocated (say, allocated before
+ * recording started) are dropped. Recorded thread ids are sparse, and never
+ * reused; threads are renumbered in order of their first op, and those left
+ * without any op are dropped.
+ */
+auto prepare(const std::vector<tsds::AllocTrace::Event>& t_events) -> Replay {
+  Replay ret{};
+  // address -> the Alloc op it came from.
+  std::unordered_map<std::uint64_t, Op> live{};
+  // recorded thread id -> index into ret.threads.
+  std::unordered_map<std::uint32_t, std::size_t> thread_ids{};
+  auto ops_of = [&](std::uint32_t t_thread) -> std::vector<Op>& {
+    auto [iter, added] = thread_ids.try_emplace(t_thread, ret.threads.size());
+    if (added) {
+      ret.threads.emplace_back();
+    }
+    return ret.threads[iter->second];
+  };
+  std::size_t live_bytes = 0;
+  for (const auto& evt : t_events) {
+    if (evt.kind == EventKind::Alloc) {
+      Op alloc_op{.timestamp = evt.timestamp,
+                  .block = ret.block_cnt++,
+                  .size = evt.size,
+                  .align = std::size_t{1} << evt.align_log2,
+                  .kind = EventKind::Alloc};
+      live[evt.addr] = alloc_op;
+      live_bytes += alloc_op.size;
+      ret.peak_live_bytes = std::max(ret.peak_live_bytes, live_bytes);
+      ops_of(evt.thread).push_back(alloc_op);
+      continue;
+    }
+    auto iter = live.find(evt.addr);
+    if (iter == live.end()) {
+      continue;
+    }
+    auto free_op = iter->second;
+    live.erase(iter);
+    live_bytes -= free_op.size;
+    free_op.timestamp = evt.timestamp;
+    free_op.kind = EventKind::Free;
+    ops_of(evt.thread).push_back(free_op);
+  }
+  ret.lanes = assign_lanes(ret.threads);
+  return ret;
+}
+
+/**
+ * @brief Reads a "kB" field, such as @c VmRSS, off @c /proc/self/status.
+ * @return The value in bytes.
+ */
+auto read_proc_status(std::string_view t_key) -> std::optional<std::size_t> {
+  std::ifstream status{"/proc/self/status"};
+  std::string line{};
+  while (std::getline(status, line)) {
+    if (!line.starts_with(t_key) || line.size() <= t_key.size() ||
+        line[t_key.size()] != ':') {
+      continue;
+    }
+    std::size_t kib{};
+    std::istringstream{line.substr(t_key.size() + 1)} >> kib;
+    return kib * 1024; // NOLINT(*magic-number*)
+  }
+  return std::nullopt;
+}
+
+/**
+ * @class RssProbe
+ * @brief Measures how much the peak RSS grows from the moment it's
+ * constructed.
+ *
+ * Resets the kernel's high-water mark first, so whatever the process
+ * touched before (say, while loading the trace) doesn't hide the growth.
+ * Linux only; elsewhere, @ref growth is always @c std::nullopt.
+ */
+class RssProbe {
+public:
+  RssProbe() {
+#ifdef __GLIBC__
+    // give back what the trace loading freed, so malloc can't quietly reuse
+    // it during the replay.
+    ::malloc_trim(0);
+#endif // __GLIBC__
+    std::ofstream clear_refs{"/proc/self/clear_refs"};
+    // 5 resets VmHWM to the current RSS.
+    clear_refs << "5";
+    clear_refs.close();
+    if (clear_refs.good()) {
+      m_baseline = read_proc_status("VmRSS");
+    }
+  }
+  /**
+   * @return @c std::nullopt if the high-water mark couldn't be reset.
+   */
+  [[nodiscard]] auto growth() const -> std::optional<std::size_t> {
+    if (!m_baseline) {
+      return std::nullopt;
+    }
+    auto peak = read_proc_status("VmHWM");
+    if (!peak) {
+      return std::nullopt;
+    }
+    return *peak - std::min(*peak, *m_baseline);
+  }
+
+private:
+  std::optional<std::size_t> m_baseline{};
+};
+
+auto percentile(const std::vector<std::uint64_t>& t_sorted, double t_pct)
+    -> std::uint64_t {
+  if (t_sorted.empty()) {
+    return 0;
+  }
+  auto idx = static_cast<std::size_t>(
+      t_pct / 100 * static_cast<double>(t_sorted.size() - 1)); // NOLINT
+  return t_sorted[idx];
+}
+
+auto parse_size(std::string_view t_str, std::size_t& t_out) -> bool {
+  const auto* end = t_str.data() + t_str.size(); // NOLINT(*pointer-arithmetic*)
+  auto [ptr, err] = std::from_chars(t_str.data(), end, t_out);
+  return err == std::errc{} && ptr == end && t_out > 0;
+}
+
+/**
+ * @brief Parses the command line. Flags may come in any position.
+ * @return @c std::nullopt on a malformed command line.
+ */
+auto parse_args(std::span<char*> t_args) -> std::optional<Options> {
+  Options ret{};
+  std::size_t positional = 0;
+  for (std::string_view arg : t_args.subspan(1)) {
+    if (arg == "--timed") {
+      ret.timed = true;
+    } else if (arg.starts_with("--pool-blocks=")) {
+      if (!parse_size(arg.substr(arg.find('=') + 1), ret.pool_blocks)) {
+        return std::nullopt;
+      }
+    } else if (arg.starts_with("--arena-bytes=")) {
+      if (!parse_size(arg.substr(arg.find('=') + 1), ret.arena_bytes)) {
+        return std::nullopt;
+      }
+    } else if (arg.starts_with("--")) {
+      return std::nullopt;
+    } else if (positional == 0) {
+      ret.trace_path = arg;
+      ++positional;
+    } else if (positional == 1) {
+      ret.alloc_name = arg;
+      ++positional;
+    } else {
+      return std::nullopt;
+    }
+  }
+  if (positional == 0 ||
+      std::ranges::find(ALLOC_NAMES, ret.alloc_name) == ALLOC_NAMES.end()) {
+    return std::nullopt;
+  }
+  return ret;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int {
+  auto opts = parse_args({argv, static_cast<std::size_t>(argc)});
+  if (!opts) {
+    std::cerr << "usage: tsds_replay <trace-file> [malloc|pmr|pool|arena] "
+                 "[--timed] [--pool-blocks=N] [--arena-bytes=N]\n";
+    return EXIT_FAILURE;
+  }
+  auto alloc_name = opts->alloc_name;
+  auto timed = opts->timed;
+  std::ifstream file{std::string{opts->trace_path}, std::ios::binary};
+  auto events = tsds::AllocTrace::read(file);
+  if (!events) {
+    std::cerr << "cannot read trace\n";
+    return EXIT_FAILURE;
+  }
+  auto replay = prepare(*events);
+  events.reset();
+
+  // Everything the replay itself needs is allocated and touched before the
+  // baseline is taken, so only the allocator shows up in the RSS growth.
+  auto blocks = std::make_unique<Block[]>(replay.block_cnt); // NOLINT
+  std::vector<std::vector<std::uint64_t>> latencies(replay.lanes.size());
+  for (std::size_t lane = 0; lane < replay.lanes.size(); ++lane) {
+    std::size_t op_cnt = 0;
+    for (auto thr : replay.lanes[lane]) {
+      op_cnt += replay.threads[thr].size();
+    }
+    latencies[lane].resize(op_cnt);
+  }
+  std::unique_ptr<Resource> resource{};
+  std::atomic<std::size_t> failed{0};
+  std::atomic<std::size_t> ready{0};
+  std::atomic<bool> go{false};
+  // set along with go if the replay is called off.
+  std::atomic<bool> cancelled{false};
+  auto replay_op = [&](const Op& t_op, std::vector<std::uint64_t>& t_lat,
+                       std::size_t& t_lat_cnt) {
+    auto& block = blocks[t_op.block];
+    if (t_op.kind == EventKind::Alloc) {
+      auto before = Clock::now();
+      auto alloc = resource->allocate(t_op.size, t_op.align);
+      auto after = Clock::now();
+      if (alloc.ptr == nullptr) {
+        // a failure tells nothing about how fast the allocator is.
+        failed.fetch_add(1, std::memory_order::relaxed);
+      } else {
+        t_lat[t_lat_cnt++] = static_cast<std::uint64_t>(
+            std::chrono::nanoseconds{after - before}.count());
+      }
+      block.alloc = alloc;
+      block.done.store(true, std::memory_order::release);
+      return;
+    }
+    // wait for the allocating thread, if it's not this one.
+    while (!block.done.load(std::memory_order::acquire)) {
+      std::this_thread::yield();
+    }
+    if (block.alloc.ptr == nullptr) {
+      return;
+    }
+    auto before = Clock::now();
+    resource->deallocate(block.alloc, t_op.size, t_op.align);
+    auto after = Clock::now();
+    t_lat[t_lat_cnt++] = static_cast<std::uint64_t>(
+        std::chrono::nanoseconds{after - before}.count());
+  };
+  std::vector<std::thread> workers{};
+  workers.reserve(replay.lanes.size());
+  for (std::size_t lane = 0; lane < replay.lanes.size(); ++lane) {
+    try {
+      workers.emplace_back([&, lane]() {
+        auto& lat = latencies[lane];
+        std::size_t lat_cnt = 0;
+        ready.fetch_add(1, std::memory_order::release);
+        while (!go.load(std::memory_order::acquire)) {
+          std::this_thread::yield();
+        }
+        if (cancelled.load(std::memory_order::relaxed)) {
+          return;
+        }
+        auto start = Clock::now();
+        for (auto thr : replay.lanes[lane]) {
+          for (const auto& op : replay.threads[thr]) {
+            if (timed) {
+              std::this_thread::sleep_until(
+                  start + std::chrono::nanoseconds{op.timestamp});
+            }
+            replay_op(op, lat, lat_cnt);
+          }
+        }
+        lat.resize(lat_cnt);
+      });
+    } catch (const std::system_error& err) {
+      std::cerr << "cannot start replay thread " << lane + 1 << " of "
+                << replay.lanes.size() << ": " << err.what() << '\n';
+      cancelled.store(true, std::memory_order::relaxed);
+      go.store(true, std::memory_order::release);
+      for (auto& worker : workers) {
+        worker.join();
+      }
+      return EXIT_FAILURE;
+    }
+  }
+  while (ready.load(std::memory_order::acquire) < workers.size()) {
+    std::this_thread::yield();
+  }
+
+  RssProbe probe{};
+  resource = make_resource(*opts);
+  auto start = Clock::now();
+  go.store(true, std::memory_order::release);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  auto rss_growth = probe.growth();
+  auto reserved = resource->reserved();
+
+  std::vector<std::uint64_t> all_lat{};
+  for (auto& lat : latencies) {
+    all_lat.insert(all_lat.end(), lat.begin(), lat.end());
+  }
+  std::ranges::sort(all_lat);
+
+  // More than this share of failed allocations, and the numbers mostly
+  // measure failures. Not worth comparing against the other allocators.
+  constexpr double MAX_FAIL_RATIO = 0.01;
+  auto fail_cnt = failed.load();
+  auto fail_ratio = (replay.block_cnt == 0)
+                        ? 0.0
+                        : static_cast<double>(fail_cnt) /
+                              static_cast<double>(replay.block_cnt);
+
+  // NOLINTBEGIN(*magic-number*)
+  std::cout << "allocator:        " << alloc_name << '\n'
+            << "threads:          " << replay.threads.size() << '\n'
+            << "replay threads:   " << replay.lanes.size() << '\n'
+            << "allocs:           " << replay.block_cnt << '\n'
+            << "failed allocs:    " << fail_cnt << '\n';
+  if (fail_ratio > MAX_FAIL_RATIO) {
+    std::cout << "status:           unusable, " << fail_ratio * 100
+              << "% of allocations failed. Raise --pool-blocks or "
+                 "--arena-bytes, or pick another allocator.\n";
+    return 2;
+  }
+  std::cout << "status:           ok\n"
+            << "ops:              " << all_lat.size() << '\n'
+            << "elapsed (s):      " << elapsed << '\n'
+            << "throughput (op/s): "
+            << static_cast<double>(all_lat.size()) / elapsed << '\n'
+            << "latency p50 (ns): " << percentile(all_lat, 50) << '\n'
+            << "latency p90 (ns): " << percentile(all_lat, 90) << '\n'
+            << "latency p99 (ns): " << percentile(all_lat, 99) << '\n'
+            << "latency p99.9 (ns): " << percentile(all_lat, 99.9) << '\n'
+            << "latency max (ns): " << (all_lat.empty() ? 0 : all_lat.back())
+            << '\n'
+            << "peak live (B):    " << replay.peak_live_bytes << '\n';
+  // NOLINTEND(*magic-number*)
+  if (reserved) {
+    std::cout << "reserved (B):     " << *reserved << '\n';
+  }
+  if (!rss_growth) {
+    std::cout << "peak RSS growth (B): n/a (needs /proc/self/clear_refs)\n";
+    return EXIT_SUCCESS;
+  }
+  std::cout << "peak RSS growth (B): " << *rss_growth << '\n';
+  // How much of the memory the allocator took was never handed out.
+  if (*rss_growth > 0) {
+    std::cout << "fragmentation:    "
+              << std::max(0.0, 1.0 - static_cast<double>(
+                                             replay.peak_live_bytes) /
+                                             static_cast<double>(*rss_growth))
+              << '\n';
+  }
+  return EXIT_SUCCESS;
+}